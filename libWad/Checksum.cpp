@@ -0,0 +1,92 @@
+#include <cstring>
+#include "Checksum.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CHECKSUM_X86
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CHECKSUM_ARM
+#endif
+
+static const uint32_t castagnoli = 0x82F63B78; // reversed polynomial
+
+struct Crc32cTable {
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ castagnoli : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+    uint32_t entries[256];
+};
+
+static uint32_t crc32cSoftware(uint32_t crc, const unsigned char* data, size_t length) {
+    static const Crc32cTable table;
+    while (length--) {
+        crc = table.entries[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(CHECKSUM_X86)
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(uint32_t crc, const unsigned char* data, size_t length) {
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        length -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (length--) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+
+static bool hasHardwareCrc() {
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+}
+#elif defined(CHECKSUM_ARM)
+static uint32_t crc32cHardware(uint32_t crc, const unsigned char* data, size_t length) {
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = __crc32cb(crc, *data++);
+    }
+    return crc;
+}
+
+static bool hasHardwareCrc() {
+    return true; // guaranteed by __ARM_FEATURE_CRC32 at compile time
+}
+#endif
+
+uint32_t crc32cUpdate(uint32_t crc, const char* data, size_t length) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    crc = ~crc;
+#if defined(CHECKSUM_X86) || defined(CHECKSUM_ARM)
+    if (hasHardwareCrc()) {
+        return ~crc32cHardware(crc, bytes, length);
+    }
+#endif
+    return ~crc32cSoftware(crc, bytes, length);
+}
+
+uint32_t crc32c(const char* data, size_t length) {
+    return crc32cUpdate(0, data, length);
+}
@@ -0,0 +1,14 @@
+#ifndef LABORATORY_CHECKSUM_H
+#define LABORATORY_CHECKSUM_H
+
+#include <cstdint>
+#include <cstddef>
+
+// CRC32C (Castagnoli) of lump data. Uses the CPU's CRC32 instruction when available (SSE4.2 on x86,
+// the CRC extension on ARMv8) and falls back to a table-driven implementation otherwise.
+uint32_t crc32cUpdate(uint32_t crc, const char* data, size_t length);
+//    Continues a running checksum; start from 0 and feed consecutive chunks.
+uint32_t crc32c(const char* data, size_t length);
+
+
+#endif //LABORATORY_CHECKSUM_H
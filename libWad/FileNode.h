@@ -24,9 +24,15 @@ struct FileNode {
         this->fileOffset = fileOffset;
 	this->descriptorOffset = descriptorOffset;
 	this->closingDescriptorOffset = -1;
+	this->parent = nullptr;
+	this->checksum = 0;
+	this->checksumValid = false;
     }
     FileNode() {
         this->filename = "";
+        this->parent = nullptr;
+        this->checksum = 0;
+        this->checksumValid = false;
     };
     void printBFS(){
         if (!this) {
@@ -62,12 +68,16 @@ struct FileNode {
 
     Type fileType;
     std::vector<FileNode*> children;
+    FileNode* parent; // containing directory, nullptr for the root
 
     uint32_t fileSize;
     uint32_t fileOffset;
     uint32_t descriptorOffset;
     uint32_t closingDescriptorOffset;
     std::string filename;
+
+    uint32_t checksum;  // CRC32C of the lump data, computed on first request
+    bool checksumValid; // cleared whenever the lump data changes
 };
 
 
@@ -0,0 +1,83 @@
+#include <iterator>
+#include "FreeSpace.h"
+
+void FreeSpace::insert(uint32_t offset, uint32_t length) {
+    byOffset[offset] = length;
+    bySize.insert({length, offset});
+}
+
+void FreeSpace::erase(std::map<uint32_t, uint32_t>::iterator hole) {
+    bySize.erase({hole->second, hole->first});
+    byOffset.erase(hole);
+}
+
+void FreeSpace::clear() {
+    byOffset.clear();
+    bySize.clear();
+}
+
+void FreeSpace::release(uint32_t offset, uint32_t length) {
+    if (length == 0) return;
+
+    auto next = byOffset.lower_bound(offset);
+    if (next != byOffset.end() && next->first == offset + length) { // merge with the hole that follows
+        length += next->second;
+        auto merged = next++;
+        erase(merged);
+    }
+    if (next != byOffset.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) { // merge with the hole that precedes
+            offset = previous->first;
+            length += previous->second;
+            erase(previous);
+        }
+    }
+    insert(offset, length);
+}
+
+bool FreeSpace::allocate(uint32_t length, uint32_t *offset) {
+    if (length == 0) return false;
+
+    // smallest hole of at least length bytes; ties go to the lowest offset
+    auto best = bySize.lower_bound({length, 0});
+    if (best == bySize.end()) return false;
+
+    uint32_t holeLength = best->first;
+    uint32_t holeOffset = best->second;
+    erase(byOffset.find(holeOffset));
+    if (holeLength > length) {
+        insert(holeOffset + length, holeLength - length);
+    }
+    *offset = holeOffset;
+    return true;
+}
+
+bool FreeSpace::claim(uint32_t offset, uint32_t length) {
+    if (length == 0) return true;
+
+    auto hole = byOffset.upper_bound(offset);
+    if (hole == byOffset.begin()) return false;
+    hole--;
+    uint32_t holeOffset = hole->first;
+    uint32_t holeEnd = hole->first + hole->second;
+    if (offset + length > holeEnd) return false;
+
+    erase(hole);
+    if (offset > holeOffset) insert(holeOffset, offset - holeOffset);
+    if (offset + length < holeEnd) insert(offset + length, holeEnd - offset - length);
+    return true;
+}
+
+uint32_t FreeSpace::holeEndingAt(uint32_t end) const {
+    auto hole = byOffset.lower_bound(end);
+    if (hole == byOffset.begin()) return 0;
+    hole--;
+    return hole->first + hole->second == end ? hole->second : 0;
+}
+
+uint64_t FreeSpace::totalFree() const {
+    uint64_t total = 0;
+    for (const auto &hole : byOffset) total += hole.second;
+    return total;
+}
@@ -0,0 +1,35 @@
+#ifndef LABORATORY_FREESPACE_H
+#define LABORATORY_FREESPACE_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+struct FreeSpace {
+    //    Map of the unused extents (holes) in the data area of a WAD, i.e. between the 12-byte header and the
+    //    descriptor table. Holes are indexed by offset, so released space can be merged with its neighbours, and
+    //    by size, so allocations are placed in the smallest hole that fits (best fit).
+    void clear();
+    void release(uint32_t offset, uint32_t length);
+    //    Marks [offset, offset + length) as free, merging it with any adjacent holes.
+    bool allocate(uint32_t length, uint32_t *offset);
+    //    Takes length bytes from the smallest hole that can hold them and places their offset in offset.
+    //    Returns false if no hole is large enough.
+    bool claim(uint32_t offset, uint32_t length);
+    //    Takes exactly [offset, offset + length) if it lies entirely within one hole (used to grow a lump in place).
+    //    Returns false, leaving the map unchanged, otherwise.
+    uint32_t holeEndingAt(uint32_t end) const;
+    //    Returns the length of the hole that ends exactly at end, or 0 if there is none.
+    uint64_t totalFree() const;
+
+    std::map<uint32_t, uint32_t> byOffset;          // hole offset -> hole length
+    std::set<std::pair<uint32_t, uint32_t>> bySize; // (hole length, hole offset)
+
+private:
+    void insert(uint32_t offset, uint32_t length);
+    void erase(std::map<uint32_t, uint32_t>::iterator hole);
+};
+
+
+#endif //LABORATORY_FREESPACE_H
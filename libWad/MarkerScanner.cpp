@@ -0,0 +1,231 @@
+#include <cstring>
+#include <algorithm>
+#include "MarkerScanner.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Byte patterns the names are compared against. Each pattern is paired with the bits (one per byte) that must
+// match; bytes marked '\xff' are left to the digit and zero checks.
+static const char exmyPattern[8] = {'E', '\xff', 'M', '\xff', 0, 0, 0, 0};
+static const char mapxxPattern[8] = {'M', 'A', 'P', '\xff', '\xff', 0, 0, 0};
+static const char start1Pattern[8] = {'\xff', '_', 'S', 'T', 'A', 'R', 'T', 0};
+static const char start2Pattern[8] = {'\xff', '\xff', '_', 'S', 'T', 'A', 'R', 'T'};
+static const char end1Pattern[8] = {'\xff', '_', 'E', 'N', 'D', 0, 0, 0};
+static const char end2Pattern[8] = {'\xff', '\xff', '_', 'E', 'N', 'D', 0, 0};
+
+static const uint8_t exmyBits = 0xF5, exmyDigits = 0x0A;
+static const uint8_t mapxxBits = 0xE7, mapxxDigits = 0x18;
+static const uint8_t prefix1Bits = 0xFE, prefix2Bits = 0xFC;
+
+// per-byte comparison results for one name, bit n describing byte n
+struct NameMasks {
+    uint8_t zero, digit, exmy, mapxx, start1, start2, end1, end2;
+};
+
+static uint64_t packName(const char* name) {
+    char padded[8] = {};
+    strncpy(padded, name, 8);
+    uint64_t packed;
+    memcpy(&packed, padded, sizeof(packed));
+    return packed;
+}
+
+// lumps that make up a binary-format map (Doom, Hexen and ZDoom extensions)
+static const uint64_t mapLumps[] = {
+        packName("THINGS"), packName("LINEDEFS"), packName("SIDEDEFS"), packName("VERTEXES"),
+        packName("SEGS"), packName("SSECTORS"), packName("NODES"), packName("SECTORS"),
+        packName("REJECT"), packName("BLOCKMAP"), packName("BEHAVIOR"), packName("SCRIPTS"),
+        packName("ZNODES"), packName("DIALOGUE")
+};
+static const uint64_t textmapName = packName("TEXTMAP");
+static const uint64_t endmapName = packName("ENDMAP");
+
+static uint8_t decode(const NameMasks &masks) {
+    // names end at the first NUL, and some tools leave junk after it: bytes past that NUL match any pattern byte.
+    // This is safe because the NUL itself only matches where a pattern has its trailing zeros.
+    int firstZero = masks.zero & -masks.zero;
+    uint8_t padding = static_cast<uint8_t>(~((firstZero << 1) - 1));
+    bool exmy = ((masks.exmy | padding) & exmyBits) == exmyBits && (masks.digit & exmyDigits) == exmyDigits;
+    bool mapxx = ((masks.mapxx | padding) & mapxxBits) == mapxxBits && (masks.digit & mapxxDigits) == mapxxDigits;
+    bool start1 = ((masks.start1 | padding) & prefix1Bits) == prefix1Bits && !(masks.zero & 0x01);
+    bool start2 = ((masks.start2 | padding) & prefix2Bits) == prefix2Bits && !(masks.zero & 0x03);
+    bool end1 = ((masks.end1 | padding) & prefix1Bits) == prefix1Bits && !(masks.zero & 0x01);
+    bool end2 = ((masks.end2 | padding) & prefix2Bits) == prefix2Bits && !(masks.zero & 0x03);
+    if (!(exmy | mapxx | start1 | start2 | end1 | end2)) return MarkerScanner::Lump; // the common case
+
+    if (exmy || mapxx) return MarkerScanner::MapMarker;
+    uint8_t prefix = (start1 || end1 ? 1 : 2) << MarkerScanner::prefixShift;
+    return (start1 || start2 ? MarkerScanner::NamespaceStart : MarkerScanner::NamespaceEnd) | prefix;
+}
+
+// the kind of a lump that follows a map marker, judged by its name
+static MarkerScanner::Kind mapLumpKind(const char* name) {
+    uint64_t packed = packName(name); // drops anything after the terminating NUL
+    if (packed == textmapName) return MarkerScanner::UdmfStart;
+    if (packed == endmapName) return MarkerScanner::UdmfEnd;
+    for (uint64_t lump : mapLumps) {
+        if (packed == lump) return MarkerScanner::MapLump;
+    }
+    return MarkerScanner::Lump;
+}
+
+// SWAR helpers: one bit per byte of a packed name, taken from each byte's high bit
+static const uint64_t lowBits = 0x7F7F7F7F7F7F7F7FULL;
+static const uint64_t highBits = 0x8080808080808080ULL;
+
+static uint8_t gatherHighBits(uint64_t bytes) {
+    return static_cast<uint8_t>((((bytes & highBits) >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+static uint8_t zeroBytes(uint64_t name) {
+    return gatherHighBits(~(((name & lowBits) + lowBits) | name));
+}
+
+static uint8_t matchBits(uint64_t name, const char* pattern) {
+    uint64_t packed;
+    memcpy(&packed, pattern, sizeof(packed));
+    return zeroBytes(name ^ packed);
+}
+
+static uint8_t digitBytes(uint64_t name) {
+    // a byte is a digit if it is at least '0' and, once '0' is taken away, no more than 9
+    uint64_t ascii = ~name & highBits;                                // bytes below 0x80
+    uint64_t atLeastZero = ((name & lowBits) + 0x5050505050505050ULL) & highBits; // low 7 bits >= 0x30
+    uint64_t atMostNine = ~((name & lowBits) + 0x4646464646464646ULL) & highBits;  // low 7 bits <= 0x39
+    return gatherHighBits(ascii & atLeastZero & atMostNine);
+}
+
+void MarkerScanner::classifyScalar(const char* table, size_t count, uint8_t* classes) {
+    for (size_t i = 0; i < count; i++) {
+        uint64_t name;
+        memcpy(&name, table + (16 * i) + 8, sizeof(name));
+        NameMasks masks{zeroBytes(name), digitBytes(name),
+                        matchBits(name, exmyPattern), matchBits(name, mapxxPattern),
+                        matchBits(name, start1Pattern), matchBits(name, start2Pattern),
+                        matchBits(name, end1Pattern), matchBits(name, end2Pattern)};
+        classes[i] = decode(masks);
+    }
+}
+
+#if defined(__SSE2__)
+static __m128i broadcastPattern(const char* pattern) {
+    uint64_t packed;
+    memcpy(&packed, pattern, sizeof(packed));
+    return _mm_set1_epi64x(packed);
+}
+
+void MarkerScanner::classify(const char* table, size_t count, uint8_t* classes) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i asciiZero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i underscores = _mm_set1_epi8('_');
+    const __m128i exmy = broadcastPattern(exmyPattern);
+    const __m128i mapxx = broadcastPattern(mapxxPattern);
+    const __m128i start1 = broadcastPattern(start1Pattern);
+    const __m128i start2 = broadcastPattern(start2Pattern);
+    const __m128i end1 = broadcastPattern(end1Pattern);
+    const __m128i end2 = broadcastPattern(end2Pattern);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        // two descriptors; their names are the upper halves, gathered into one register
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + (16 * i)));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + (16 * i) + 16));
+        __m128i names = _mm_unpackhi_epi64(first, second);
+
+        // most names are ordinary lumps: a marker needs 'E' or 'M' in byte 0, or '_' in byte 1 or 2
+        int head = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(names, exmy), _mm_cmpeq_epi8(names, mapxx)));
+        int underscore = _mm_movemask_epi8(_mm_cmpeq_epi8(names, underscores));
+        if (!((head & 0x0101) | (underscore & 0x0606))) {
+            classes[i] = Lump;
+            classes[i + 1] = Lump;
+            continue;
+        }
+
+        // unsigned byte - '0' <= 9 marks the digits
+        __m128i shifted = _mm_sub_epi8(names, asciiZero);
+        int digit = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(shifted, nine), shifted));
+        int zeroBits = _mm_movemask_epi8(_mm_cmpeq_epi8(names, zero));
+        int exmyBitsBoth = _mm_movemask_epi8(_mm_cmpeq_epi8(names, exmy));
+        int mapxxBitsBoth = _mm_movemask_epi8(_mm_cmpeq_epi8(names, mapxx));
+        int start1Both = _mm_movemask_epi8(_mm_cmpeq_epi8(names, start1));
+        int start2Both = _mm_movemask_epi8(_mm_cmpeq_epi8(names, start2));
+        int end1Both = _mm_movemask_epi8(_mm_cmpeq_epi8(names, end1));
+        int end2Both = _mm_movemask_epi8(_mm_cmpeq_epi8(names, end2));
+
+        for (int half = 0; half < 2; half++) {
+            int shift = 8 * half;
+            NameMasks masks{
+                    static_cast<uint8_t>(zeroBits >> shift), static_cast<uint8_t>(digit >> shift),
+                    static_cast<uint8_t>(exmyBitsBoth >> shift), static_cast<uint8_t>(mapxxBitsBoth >> shift),
+                    static_cast<uint8_t>(start1Both >> shift), static_cast<uint8_t>(start2Both >> shift),
+                    static_cast<uint8_t>(end1Both >> shift), static_cast<uint8_t>(end2Both >> shift)};
+            classes[i + half] = decode(masks);
+        }
+    }
+    classifyScalar(table + (16 * i), count - i, classes + i);
+}
+#else
+void MarkerScanner::classify(const char* table, size_t count, uint8_t* classes) {
+    classifyScalar(table, count, classes);
+}
+#endif
+
+void MarkerScanner::resolveMaps(const char* table, uint8_t* classes, size_t count) {
+    bool open = false;        // inside a map
+    bool udmf = false;        // inside a TEXTMAP ... ENDMAP map
+    bool afterMarker = false; // previous entry was the map marker itself
+    for (size_t i = 0; i < count; i++) {
+        Kind current = kind(classes[i]);
+        if (open && current != MapMarker) {
+            // names only need to be looked up while a map is open, which keeps this pass cheap
+            if (current == Lump) {
+                current = mapLumpKind(table + (16 * i) + 8);
+                classes[i] = current;
+            }
+            if (udmf) {
+                classes[i] |= inMap;
+                if (current == UdmfEnd) open = false;
+                continue;
+            }
+            if ((afterMarker && current == UdmfStart) || current == MapLump) {
+                classes[i] |= inMap;
+                udmf = current == UdmfStart;
+                afterMarker = false;
+                continue;
+            }
+            open = false;
+        }
+        if (current == MapMarker) {
+            open = true;
+            udmf = false;
+            afterMarker = true;
+        }
+    }
+}
+
+std::vector<uint8_t> MarkerScanner::scan(const char* table, size_t count) {
+    std::vector<uint8_t> classes(count);
+    classify(table, count, classes.data());
+    resolveMaps(table, classes.data(), count);
+    return classes;
+}
+
+uint8_t MarkerScanner::classifyName(const std::string &name) {
+    char descriptor[16] = {};
+    memcpy(descriptor + 8, name.data(), std::min<size_t>(name.length(), 8));
+    uint8_t lumpClass;
+    classifyScalar(descriptor, 1, &lumpClass);
+    if (kind(lumpClass) == Lump) lumpClass = mapLumpKind(descriptor + 8);
+    return lumpClass;
+}
+
+bool MarkerScanner::namespaceMatches(const std::string &start, const std::string &end) {
+    if (start == end) return true;
+    auto doubled = [](const std::string &single, const std::string &twice) {
+        return single.length() == 1 && twice.length() == 2 && twice.at(0) == single.at(0) && twice.at(1) == single.at(0);
+    };
+    return doubled(start, end) || doubled(end, start);
+}
@@ -0,0 +1,56 @@
+#ifndef LABORATORY_MARKERSCANNER_H
+#define LABORATORY_MARKERSCANNER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct MarkerScanner {
+    //    Classifies the 8-byte names of a raw descriptor table (16 bytes per descriptor, name in the last 8) in bulk,
+    //    producing one class byte per descriptor for the tree builder. Names are compared against the marker
+    //    patterns two at a time with SSE2 where available; the scalar path produces identical output.
+    //
+    //    Recognized markers: ExMy and MAPxx map markers, and X_START/X_END or XX_START/XX_END namespace markers.
+    //    A map owns the known map lumps that directly follow its marker (Doom, Hexen and ZDoom node lumps), or,
+    //    for UDMF maps, everything from TEXTMAP through ENDMAP.
+
+    enum Kind : uint8_t {
+        Lump,           // ordinary lump
+        MapMarker,      // ExMy or MAPxx
+        NamespaceStart, // X_START or XX_START
+        NamespaceEnd,   // X_END or XX_END
+        MapLump,        // one of the standard binary-format map lumps (THINGS, LINEDEFS, BEHAVIOR, ...)
+        UdmfStart,      // TEXTMAP
+        UdmfEnd         // ENDMAP
+        // the last three are only assigned by resolveMaps (to lumps after a map marker) and classifyName
+    };
+
+    static const uint8_t kindMask = 0x07;
+    static const uint8_t prefixShift = 3;   // namespace markers: length of the name before "_START"/"_END"
+    static const uint8_t prefixMask = 0x18;
+    static const uint8_t inMap = 0x80;      // set by resolveMaps on lumps that belong to the preceding map marker
+
+    static Kind kind(uint8_t lumpClass) { return static_cast<Kind>(lumpClass & kindMask); }
+    static int prefixLength(uint8_t lumpClass) { return (lumpClass & prefixMask) >> prefixShift; }
+
+    static void classify(const char* table, size_t count, uint8_t* classes);
+    //    Fills classes[0..count) from the raw descriptor table, using SIMD when the CPU supports it.
+    static void classifyScalar(const char* table, size_t count, uint8_t* classes);
+    //    Portable equivalent of classify.
+    static void resolveMaps(const char* table, uint8_t* classes, size_t count);
+    //    Marks map membership (inMap) on an array produced by classify. The lumps following a map marker are
+    //    also given their map lump kinds here, since only they need their names looked up.
+    static std::vector<uint8_t> scan(const char* table, size_t count);
+    //    classify followed by resolveMaps.
+
+    static uint8_t classifyName(const std::string &name);
+    //    Classifies a single name (at most 8 characters), including the map lump kinds, e.g. to validate a lump
+    //    being created.
+    static bool namespaceMatches(const std::string &start, const std::string &end);
+    //    Returns true if an _END marker with prefix end closes a namespace opened with prefix start. Doubled
+    //    prefixes are interchangeable with single ones, so FF_START may be closed by F_END and F_START by FF_END.
+};
+
+
+#endif //LABORATORY_MARKERSCANNER_H
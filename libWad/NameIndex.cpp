@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <tuple>
+#include "NameIndex.h"
+
+static bool entryLess(const NameIndex::Entry &a, const NameIndex::Entry &b) {
+    return a.key < b.key;
+}
+
+// first entry whose key starts with prefix, and the entry just past the last one
+static std::pair<std::vector<NameIndex::Entry>::const_iterator, std::vector<NameIndex::Entry>::const_iterator>
+prefixRange(const std::vector<NameIndex::Entry> &entries, const std::string &prefix) {
+    auto first = std::lower_bound(entries.begin(), entries.end(), NameIndex::Entry{prefix, nullptr}, entryLess);
+    auto last = first;
+    while (last != entries.end() && last->key.compare(0, prefix.length(), prefix) == 0) {
+        last++;
+    }
+    return {first, last};
+}
+
+static void insertSorted(std::vector<NameIndex::Entry> &entries, const std::string &key, FileNode* node) {
+    NameIndex::Entry entry{key, node};
+    entries.insert(std::upper_bound(entries.begin(), entries.end(), entry, entryLess), entry);
+}
+
+static void removeSorted(std::vector<NameIndex::Entry> &entries, const std::string &key, FileNode* node) {
+    auto range = std::equal_range(entries.begin(), entries.end(), NameIndex::Entry{key, nullptr}, entryLess);
+    for (auto it = range.first; it != range.second; it++) {
+        if (it->node == node) {
+            entries.erase(it);
+            return;
+        }
+    }
+}
+
+std::string NameIndex::lumpName(const FileNode* node) {
+    std::string str = node->filename;
+    str.erase(std::remove(str.begin(), str.end(), '\0'), str.end());
+    return str;
+}
+
+bool NameIndex::globMatch(const char* pattern, const char* name) {
+    // iterative matcher; on a mismatch, retry from the most recent '*' with one more character consumed
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*name) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        }
+        else if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        }
+        else if (star) {
+            pattern = star + 1;
+            name = ++resume;
+        }
+        else {
+            return false;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return *pattern == '\0';
+}
+
+void NameIndex::clear() {
+    byName.clear();
+    byReversed.clear();
+}
+
+void NameIndex::build(const std::vector<FileNode*> &nodes) {
+    // sorting once keeps loading linearithmic; equal names stay in the order given, as with insert
+    clear();
+    for (FileNode* node : nodes) {
+        if (!node->isStandardFile()) continue;
+        std::string name = lumpName(node);
+        byName.push_back({name, node});
+        byReversed.push_back({std::string(name.rbegin(), name.rend()), node});
+    }
+    std::stable_sort(byName.begin(), byName.end(), entryLess);
+    std::stable_sort(byReversed.begin(), byReversed.end(), entryLess);
+}
+
+void NameIndex::insert(FileNode* node) {
+    if (!node->isStandardFile()) return;
+    std::string name = lumpName(node);
+    insertSorted(byName, name, node);
+    insertSorted(byReversed, std::string(name.rbegin(), name.rend()), node);
+}
+
+void NameIndex::remove(FileNode* node) {
+    if (!node->isStandardFile()) return;
+    std::string name = lumpName(node);
+    removeSorted(byName, name, node);
+    removeSorted(byReversed, std::string(name.rbegin(), name.rend()), node);
+}
+
+int NameIndex::find(const std::string &pattern, std::vector<FileNode*> *results) const {
+    size_t firstWildcard = pattern.find_first_of("*?");
+    size_t lastWildcard = pattern.find_last_of("*?");
+
+    std::vector<FileNode*> matches;
+    if (firstWildcard == std::string::npos) {
+        // exact name
+        auto range = std::equal_range(byName.begin(), byName.end(), Entry{pattern, nullptr}, entryLess);
+        for (auto it = range.first; it != range.second; it++) {
+            matches.push_back(it->node);
+        }
+    }
+    else {
+        std::string prefix = pattern.substr(0, firstWildcard);
+        std::string suffix = pattern.substr(lastWildcard + 1);
+
+        // narrow the candidates by the longer of the literal prefix and suffix
+        std::vector<Entry>::const_iterator first, last;
+        if (prefix.empty() && suffix.empty()) {
+            first = byName.begin();
+            last = byName.end();
+        }
+        else if (prefix.length() >= suffix.length()) {
+            std::tie(first, last) = prefixRange(byName, prefix);
+        }
+        else {
+            std::tie(first, last) = prefixRange(byReversed, std::string(suffix.rbegin(), suffix.rend()));
+        }
+
+        bool reversed = !(prefix.empty() && suffix.empty()) && prefix.length() < suffix.length();
+        for (auto it = first; it != last; it++) {
+            std::string name = reversed ? std::string(it->key.rbegin(), it->key.rend()) : it->key;
+            if (globMatch(pattern.c_str(), name.c_str())) {
+                matches.push_back(it->node);
+            }
+        }
+    }
+
+    // report matches in WAD order
+    std::sort(matches.begin(), matches.end(), [](const FileNode* a, const FileNode* b) {
+        return a->descriptorOffset < b->descriptorOffset;
+    });
+    results->insert(results->end(), matches.begin(), matches.end());
+    return matches.size();
+}
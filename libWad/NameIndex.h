@@ -0,0 +1,39 @@
+#ifndef LABORATORY_NAMEINDEX_H
+#define LABORATORY_NAMEINDEX_H
+
+#include <string>
+#include <vector>
+#include "FileNode.h"
+
+struct NameIndex {
+    //    Index over the names of every lump (standard file) in the tree, so that name queries can be answered
+    //    without walking the directory structure. Lumps are kept sorted twice: once by name (prefix queries)
+    //    and once by reversed name (suffix queries). Glob patterns are narrowed using whichever literal prefix
+    //    or suffix they have, and only the remaining candidates are matched against the full pattern.
+    struct Entry {
+        std::string key;
+        FileNode* node;
+    };
+
+    void clear();
+    void build(const std::vector<FileNode*> &nodes);
+    //    Replaces the index with the standard files among nodes, sorting each order once (used when loading a WAD).
+    void insert(FileNode* node);
+    //    Adds node under its current filename. Nodes that are not standard files are ignored.
+    void remove(FileNode* node);
+    //    Removes node from the index. Must be called before the node's filename is changed.
+    int find(const std::string &pattern, std::vector<FileNode*> *results) const;
+    //    Places every indexed lump whose name matches pattern into results, in the order the lumps appear in the
+    //    WAD file. '*' matches any run of characters and '?' matches exactly one. Returns the number of matches.
+    size_t size() const { return byName.size(); }
+
+    static std::string lumpName(const FileNode* node);
+    //    Returns node's filename with the '\0' padding removed.
+    static bool globMatch(const char* pattern, const char* name);
+
+    std::vector<Entry> byName;     // sorted by key
+    std::vector<Entry> byReversed; // sorted by key, where key is the reversed name
+};
+
+
+#endif //LABORATORY_NAMEINDEX_H
@@ -1,7 +1,47 @@
 #include <stack>
 #include <algorithm>
 #include <cstring>
+#include <thread>
+#include <atomic>
+#include <filesystem>
 #include "Wad.h"
+#include "Checksum.h"
+#include "MarkerScanner.h"
+
+void Wad::splitPath(const std::string &path, std::string *parent, std::string *name) {
+    std::string trimmed = path;
+    if (trimmed.length() > 1 && trimmed.at(trimmed.length()-1) == '/') trimmed = trimmed.substr(0, trimmed.length()-1);
+    size_t index = trimmed.find_last_of('/');
+    *parent = index == 0 ? "/" : trimmed.substr(0, index);
+    *name = trimmed.substr(index + 1);
+}
+
+// Pads name with '\0' to the 8 bytes a descriptor stores.
+static std::string padName(const std::string &name) {
+    std::string result = name.substr(0, 8);
+    result.append(8 - result.size(), '\0');
+    return result;
+}
+
+bool Wad::isValidLumpName(const std::string &name, const FileNode* previous) {
+    if (name.empty() || name.length() > 8) return false;
+    // markers would change the tree structure when the WAD is next loaded, and so would a map lump name placed
+    // directly after a map, which would be absorbed into it
+    MarkerScanner::Kind kind = MarkerScanner::kind(MarkerScanner::classifyName(name));
+    if (kind == MarkerScanner::Lump) return true;
+    if (kind == MarkerScanner::MapMarker || kind == MarkerScanner::NamespaceStart || kind == MarkerScanner::NamespaceEnd) return false;
+    return !previous || !previous->isMapDirectory();
+}
+
+FileNode* Wad::entryBefore(const FileNode* parent, const FileNode* node, const FileNode* skip) {
+    const std::vector<FileNode*> &children = parent->children;
+    auto it = std::find(children.begin(), children.end(), node);
+    while (it != children.begin()) {
+        it--;
+        if (*it != skip) return *it;
+    }
+    return nullptr;
+}
 
 Wad* Wad::loadWad(const std::string &path) {
 
@@ -28,75 +68,95 @@ Wad* Wad::loadWad(const std::string &path) {
     // Read descriptor length
     inputFile.read(reinterpret_cast<char*>(&wad->descriptorOffset), sizeof(wad->descriptorOffset));
 
-    // jump to the descriptors (jump descriptorOffset bytes forward) and read those
+    // jump to the descriptors (jump descriptorOffset bytes forward) and read the whole table at once
+    std::vector<char> table(16 * wad->numDescriptors);
     inputFile.seekg(wad->descriptorOffset);
-    for (int i = 0; i < wad->numDescriptors; i++){
-        Wad::Descriptor desc{};
-        // Read element offset (location of file ASCII's contents)
-        inputFile.read(reinterpret_cast<char*>(&desc.elementOffset), sizeof(desc.elementOffset));
-
-        // Read element length
-        inputFile.read(reinterpret_cast<char*>(&desc.elementLength), sizeof(desc.elementLength));
+    inputFile.read(table.data(), table.size());
+    inputFile.close();
 
-        // Read ASCII
-        inputFile.read(desc.ascii, sizeof(char) * 8);
+    wad->descriptors.resize(wad->numDescriptors);
+    for (int i = 0; i < wad->numDescriptors; i++){
+        Wad::Descriptor &desc = wad->descriptors.at(i);
+        // element offset (location of file ASCII's contents), element length, then the 8 ASCII name bytes
+        memcpy(&desc.elementOffset, &table[16 * i], sizeof(desc.elementOffset));
+        memcpy(&desc.elementLength, &table[16 * i + 4], sizeof(desc.elementLength));
+        memcpy(desc.ascii, &table[16 * i + 8], sizeof(char) * 8);
         desc.ascii[8] = '\0';
-
-        // debug statement
-//        std::cout << "Descriptor " << i << std::endl;
-//        std::cout << "Element Offset: " << desc.elementOffset << std::endl;
-//        std::cout << "Element Length: " << desc.elementLength << std::endl;
-//        std::cout << "Element Ascii: " << desc.ascii << std::endl;
-//        std::cout << "---------------------------------------" << std::endl;
-
-        wad->descriptors.push_back(desc);
+        // the name ends at its first NUL; some tools leave junk after it
+        size_t nameLength = strnlen(desc.ascii, 8);
+        memset(desc.ascii + nameLength, 0, 8 - nameLength);
     }
 
-    inputFile.close();
+    // classify every name up front: markers, namespace pairs and which lumps belong to which map
+    std::vector<uint8_t> classes = MarkerScanner::scan(table.data(), wad->numDescriptors);
 
     // set up tree structure based on descriptors;
     wad->baseDirectory = new FileNode("root", FileNode::Type::NamespaceDirectory, -1, -1, -1);
     wad->baseDirectory->closingDescriptorOffset = wad->descriptorOffset + (16 * wad->numDescriptors);
-    int index = -999;
     std::stack<FileNode*> s;
     s.push(wad->baseDirectory);
+    std::vector<FileNode*> lumps; // indexed in one pass once the tree is built
     for (int i = 0; i < wad->numDescriptors; i++){
         // convert ascii char array to string (ease of use)
-        Wad::Descriptor desc = wad->descriptors.at(i);
-        std::string givenName = "";
-        for (char j : desc.ascii){
-            givenName += j;
-        }
+        Wad::Descriptor &desc = wad->descriptors.at(i);
+        std::string givenName(desc.ascii, 9);
+        uint8_t lumpClass = classes.at(i);
 
-        // ensure the map marker directory gets 10 files placed inside it
-        if (i - 11 == index){
-            index = -999;
+        // a map directory holds exactly the lumps the scanner marked as belonging to it
+        if (s.top()->isMapDirectory() && !(lumpClass & MarkerScanner::inMap)){
             s.pop();
         }
 
-        if (givenName.at(0) == 'E' && isdigit(givenName.at(1)) && givenName.at(2) == 'M' && isdigit(givenName.at(3))){ // map marker directory
+        if (lumpClass & MarkerScanner::inMap){ // lump inside a map
+            auto* newNode = new FileNode(givenName, FileNode::Type::StandardFile, desc.elementLength, desc.elementOffset, wad->descriptorOffset + (i * 16));
+            newNode->parent = s.top();
+            s.top()->children.push_back(newNode);
+            lumps.push_back(newNode);
+        }
+        else if (MarkerScanner::kind(lumpClass) == MarkerScanner::MapMarker){ // map marker directory
             auto* newNode = new FileNode(givenName, FileNode::Type::MapDirectory, -1, desc.elementOffset, wad->descriptorOffset + (i * 16));
+            newNode->parent = s.top();
             s.top()->children.push_back(newNode);
             s.push(newNode);
-
-            index = i;
         }
-        else if (givenName.substr(2, 6) == "_START" ){ // namespace directory beginning
-            auto* newNode = new FileNode(givenName.substr(0, 2), FileNode::Type::NamespaceDirectory, -1, desc.elementOffset, wad->descriptorOffset + (i * 16));
+        else if (MarkerScanner::kind(lumpClass) == MarkerScanner::NamespaceStart){ // namespace directory beginning
+            auto* newNode = new FileNode(givenName.substr(0, MarkerScanner::prefixLength(lumpClass)), FileNode::Type::NamespaceDirectory, -1, desc.elementOffset, wad->descriptorOffset + (i * 16));
+            newNode->parent = s.top();
             s.top()->children.push_back(newNode);
             s.push(newNode);
         }
-        else if (givenName.substr(2, 4) == "_END"){ // namespace directory ending
-            if (givenName.substr(0, 2) == s.top()->filename.substr(0, 2)){
+        else if (MarkerScanner::kind(lumpClass) == MarkerScanner::NamespaceEnd){ // namespace directory ending
+            if (s.top() != wad->baseDirectory && MarkerScanner::namespaceMatches(s.top()->filename, givenName.substr(0, MarkerScanner::prefixLength(lumpClass)))){
                 s.top()->closingDescriptorOffset = wad->descriptorOffset + (i * 16);
                 s.pop();
             }
         }
         else { // generic file
             auto* newNode = new FileNode(givenName, FileNode::Type::StandardFile, desc.elementLength, desc.elementOffset, wad->descriptorOffset + (i * 16));
+            newNode->parent = s.top();
             s.top()->children.push_back(newNode);
+            lumps.push_back(newNode);
         }
     }
+    wad->nameIndex.build(lumps);
+
+    // every byte of the data area that no descriptor points into is free for reuse. Some WADs store lump data after
+    // the descriptor table; the table is moved past that data before the first update (see placeTableAfterData)
+    std::vector<std::pair<uint32_t, uint32_t>> extents;
+    wad->trailingDataEnd = 0;
+    for (const Wad::Descriptor &desc : wad->descriptors){
+        if (desc.elementLength == 0) continue;
+        extents.push_back({desc.elementOffset, desc.elementOffset + desc.elementLength});
+        if (desc.elementOffset >= wad->descriptorOffset) wad->trailingDataEnd = std::max(wad->trailingDataEnd, extents.back().second);
+    }
+    extents.push_back({wad->descriptorOffset, wad->descriptorOffset + (16 * wad->numDescriptors)});
+    std::sort(extents.begin(), extents.end());
+    uint32_t position = 12; // end of the header
+    for (const auto &extent : extents){
+        if (extent.first > position) wad->freeSpace.release(position, extent.first - position);
+        position = std::max(position, extent.second);
+    }
+
     return wad;
 }
 
@@ -114,6 +174,23 @@ bool Wad::isContent(const std::string &path) {
 FileNode *Wad::pathToNode(std::string path, FileNode* fileNode) {
     if (path == "/") return fileNode;
     if (path == "") return nullptr;
+    if (fileNode == this->baseDirectory && path.compare(0, strlen(searchDirectory) + 1, std::string(searchDirectory) + "/") == 0) {
+        // "/.search/<pattern>/<entry>" resolves to the matching lump; the query directories themselves have no node
+        std::string query = path.substr(strlen(searchDirectory) + 1);
+        if (!query.empty() && query.at(query.length()-1) == '/') query = query.substr(0, query.length()-1);
+        size_t split = query.find('/');
+        if (split == std::string::npos) return nullptr;
+        std::string pattern = query.substr(0, split);
+        std::string entry = query.substr(split + 1);
+        if (entry.empty() || entry.find('/') != std::string::npos) return nullptr;
+
+        // the entry name is the lump's own path, so resolve it directly and only check that one lump
+        std::replace(entry.begin(), entry.end(), ':', '/');
+        FileNode* match = pathToNode("/" + entry, this->baseDirectory);
+        if (!match || !match->isStandardFile()) return nullptr;
+        if (!NameIndex::globMatch(pattern.c_str(), NameIndex::lumpName(match).c_str())) return nullptr;
+        return match;
+    }
     if (path.at(path.length()-1) == '/') path = path.substr(0, path.length()-1);
     path = path.substr(1, path.length()-1);
     std::string snippedPath = "";
@@ -142,7 +219,31 @@ FileNode *Wad::pathToNode(std::string path, FileNode* fileNode) {
     return nullptr;
 }
 
+std::string Wad::nodeToPath(FileNode* fileNode) {
+    if (fileNode == this->baseDirectory) return "/";
+    std::string path = "";
+    for (FileNode* current = fileNode; current && current != this->baseDirectory; current = current->parent) {
+        path = "/" + NameIndex::lumpName(current) + path;
+    }
+    return path;
+}
+
+int Wad::findLumps(const std::string &pattern, std::vector<FileNode*> *results) {
+    return this->nameIndex.find(pattern, results);
+}
+
+bool Wad::isSearchDirectory(const std::string &path) {
+    std::string trimmed = path;
+    if (trimmed.length() > 1 && trimmed.at(trimmed.length()-1) == '/') trimmed = trimmed.substr(0, trimmed.length()-1);
+    if (trimmed == searchDirectory) return true;
+    std::string root = std::string(searchDirectory) + "/";
+    if (trimmed.compare(0, root.length(), root) != 0) return false;
+    std::string pattern = trimmed.substr(root.length());
+    return !pattern.empty() && pattern.find('/') == std::string::npos;
+}
+
 bool Wad::isDirectory(const std::string &path) {
+    if (isSearchDirectory(path)) return true;
     FileNode* thisNode = pathToNode(path, this->baseDirectory);
     if (thisNode != nullptr){
         return (thisNode->isMapDirectory() || thisNode->isStandardDirectory());
@@ -193,7 +294,88 @@ int Wad::getContents(const std::string &path, char *buffer, int length, int offs
     return bytesRead;
 }
 
+bool Wad::checksumNode(FileNode* fileNode) {
+    if (fileNode->checksumValid) return true;
+
+    std::ifstream inputFile(this->wadFile, std::ios::in | std::ios::binary);
+    if (!inputFile.is_open()){
+        std::cout << "File failed to open." << std::endl;
+        return false;
+    }
+
+    // hash the lump in fixed-size chunks so large lumps don't need to be held in memory
+    std::vector<char> buffer(64 * 1024);
+    uint32_t crc = 0;
+    uint32_t remaining = fileNode->fileSize;
+    inputFile.seekg(fileNode->fileOffset);
+    while (remaining > 0) {
+        uint32_t chunk = std::min(remaining, static_cast<uint32_t>(buffer.size()));
+        inputFile.read(buffer.data(), chunk);
+        if (inputFile.gcount() != chunk) return false;
+        crc = crc32cUpdate(crc, buffer.data(), chunk);
+        remaining -= chunk;
+    }
+
+    fileNode->checksum = crc;
+    fileNode->checksumValid = true;
+    return true;
+}
+
+int Wad::getChecksum(const std::string &path, uint32_t *checksum) {
+    FileNode* thisNode = pathToNode(path, this->baseDirectory);
+    if (!thisNode || !thisNode->isStandardFile()) return -1;
+    if (!checksumNode(thisNode)) return -1;
+    *checksum = thisNode->checksum;
+    return 0;
+}
+
+int Wad::computeChecksums(int threads) {
+    // every lump is in the name index, so there is no need to walk the tree to find them
+    std::vector<FileNode*> pending;
+    for (const NameIndex::Entry &entry : this->nameIndex.byName) {
+        if (!entry.node->checksumValid) pending.push_back(entry.node);
+    }
+    if (pending.empty()) return 0;
+
+    // hash in WAD order so each worker reads mostly sequentially
+    std::sort(pending.begin(), pending.end(), [](const FileNode* a, const FileNode* b) {
+        return a->fileOffset < b->fileOffset;
+    });
+
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, static_cast<int>(pending.size()));
+
+    std::atomic<size_t> next(0);
+    std::atomic<int> hashed(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            if (checksumNode(pending.at(i))) hashed++;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    return hashed;
+}
+
 int Wad::getDirectory(const std::string &path, std::vector<std::string> *directory) {
+    if (isSearchDirectory(path)) {
+        std::string trimmed = path;
+        if (trimmed.at(trimmed.length()-1) == '/') trimmed = trimmed.substr(0, trimmed.length()-1);
+        if (trimmed == searchDirectory) return 0; // patterns are looked up on demand, never listed
+        std::vector<FileNode*> matches;
+        findLumps(trimmed.substr(strlen(searchDirectory) + 1), &matches);
+        for (FileNode* match : matches) {
+            std::string entry = nodeToPath(match).substr(1);
+            std::replace(entry.begin(), entry.end(), '/', ':');
+            directory->push_back(entry);
+        }
+        return matches.size();
+    }
     FileNode* thisNode = pathToNode(path, this->baseDirectory);
     if (!thisNode || thisNode->isStandardFile()) return -1;
     if (thisNode->children.empty()) return 0;
@@ -231,11 +413,20 @@ void Wad::createDirectory(const std::string &path) {
     if (newName.at(newName.length()-1) == '/') {
 	newName = newName.substr(0, newName.length()-1);
     }
-    if (newName.size() > 2) return;
+    if (newName.empty() || newName.size() > 2) return;
+    if (pathToNode(path, this->baseDirectory)) return; // the name is already taken
+
+    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
+    if (!wadFile.is_open()) {
+        std::cerr << "Failed to open WAD file for updating." << std::endl;
+        return;
+    }
+    placeTableAfterData(wadFile);
 
     // update the tree to reflect the new directory
     auto* newNode = new FileNode(newName, FileNode::Type::NamespaceDirectory, -1, 0, thisNode->closingDescriptorOffset);
     newNode->closingDescriptorOffset = thisNode->closingDescriptorOffset + 16;
+    newNode->parent = thisNode;
     thisNode->children.push_back(newNode);
 
     // update the .wad file to reflect the new directory
@@ -248,11 +439,6 @@ void Wad::createDirectory(const std::string &path) {
 
     std::vector<char> buffer(dataShiftSize);
 
-    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
-    if (!wadFile.is_open()) {
-        std::cerr << "Failed to open WAD file for updating." << std::endl;
-        return;
-    }
 
     // read old data into buffer
     wadFile.seekp(insertPosition);
@@ -301,21 +487,9 @@ void Wad::createDirectory(const std::string &path) {
 // Close the file
     wadFile.close();
 
-    std::queue<FileNode*> q;
-    q.push(this->baseDirectory);
-    while (!q.empty()){
-	int size = q.size();
-	for (int j = 0; j < size; j++){
-	    FileNode* current = q.front();
-	    q.pop();
-
-	    if (current->descriptorOffset >= insertPosition && current != newNode) current->descriptorOffset += 32;
-	    if (current->closingDescriptorOffset >= insertPosition && current != newNode) current->closingDescriptorOffset += 32;
-	    for (int i = 0; i < current->children.size(); i++){
-		q.push(current->children.at(i));
-	    }
-	}
-    }
+    shiftDescriptorOffsets(insertPosition, 32);
+    newNode->descriptorOffset = insertPosition;
+    newNode->closingDescriptorOffset = insertPosition + 16;
 
 //    this = Wad::loadWad(this->wadFile);
 }
@@ -341,21 +515,21 @@ void Wad::createFile(const std::string &path) {
     std::string newName = path.substr(index + 1, path.length()-index-1); // directory to be created
 
     // prevent _start, _end, elmo
-    if (newName.length() > 8) return;
+    if (!isValidLumpName(newName, entryBefore(thisNode, nullptr))) return;
+    if (pathToNode(path, this->baseDirectory)) return; // the name is already taken
 
-    if (newName.at(0) == 'E' && isdigit(newName.at(1)) && newName.at(2) == 'M' && isdigit(newName.at(3))){ // map marker directory
+    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
+    if (!wadFile.is_open()) {
+        std::cerr << "Failed to open WAD file for updating." << std::endl;
         return;
     }
-    if (newName.length() >= 6){
-	if (newName.substr(newName.length()-6) == "_START") return;
-    }
-    if (newName.length() >= 4){
-	if (newName.substr(newName.length()-4) == "_END") return;
-    }
+    placeTableAfterData(wadFile);
 
     // update the tree to reflect the new directory
     auto* newNode = new FileNode(newName, FileNode::Type::StandardFile, 0, 0, thisNode->closingDescriptorOffset);
+    newNode->parent = thisNode;
     thisNode->children.push_back(newNode);
+    this->nameIndex.insert(newNode);
 
     // thisNode->endOffset is where the parent Node's closing descriptor is located in the .wad
     long insertPosition = thisNode->closingDescriptorOffset /* compute insert position */;
@@ -364,11 +538,6 @@ void Wad::createFile(const std::string &path) {
     int dataShiftSize = fileSizeInBytes-insertPosition; // the data we must shift forward is between our insertPosition and the file's end
     std::vector<char> buffer(dataShiftSize);
 
-    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
-    if (!wadFile.is_open()) {
-        std::cerr << "Failed to open WAD file for updating." << std::endl;
-        return;
-    }
 
     // read old data into buffer
     wadFile.seekp(insertPosition);
@@ -401,33 +570,193 @@ void Wad::createFile(const std::string &path) {
     wadFile.close();
 
 
+    shiftDescriptorOffsets(insertPosition, 16);
+    newNode->descriptorOffset = insertPosition;
+}
+
+void Wad::shiftDescriptorOffsets(uint32_t from, int64_t delta) {
+    // every descriptor at or past from moves by delta; -1 marks offsets that don't exist (root, map closings)
     std::queue<FileNode*> q;
     q.push(this->baseDirectory);
     while (!q.empty()){
-	int size = q.size();
-	for (int j = 0; j < size; j++){
-	    FileNode* current = q.front();
-	    q.pop();
+        FileNode* current = q.front();
+        q.pop();
+
+        if (current->descriptorOffset != static_cast<uint32_t>(-1) && current->descriptorOffset >= from) current->descriptorOffset += delta;
+        if (current->closingDescriptorOffset != static_cast<uint32_t>(-1) && current->closingDescriptorOffset >= from) current->closingDescriptorOffset += delta;
+        for (int i = 0; i < current->children.size(); i++){
+            q.push(current->children.at(i));
+        }
+    }
+}
 
-	    if (current->descriptorOffset >= insertPosition && current != newNode) current->descriptorOffset += 16;
-	    if (current->closingDescriptorOffset >= insertPosition && current != newNode) current->closingDescriptorOffset += 16;
-	    for (int i = 0; i < current->children.size(); i++){
-		q.push(current->children.at(i));
-	    }
-	}
+void Wad::moveDescriptorTable(std::fstream &wadFile, uint32_t newOffset) {
+    uint32_t tableSize = 16 * this->numDescriptors;
+    std::vector<char> table(tableSize);
+    wadFile.seekg(this->descriptorOffset);
+    wadFile.read(table.data(), tableSize);
+    wadFile.seekp(newOffset);
+    wadFile.write(table.data(), tableSize);
+
+    shiftDescriptorOffsets(this->descriptorOffset, static_cast<int64_t>(newOffset) - this->descriptorOffset);
+    this->descriptorOffset = newOffset;
+    wadFile.seekp(8);
+    wadFile.write(reinterpret_cast<const char *>(&this->descriptorOffset), sizeof(this->descriptorOffset));
+}
+
+void Wad::placeTableAfterData(std::fstream &wadFile) {
+    // lump data past the table would be overwritten when the table grows and cut off when the file is trimmed
+    if (this->trailingDataEnd == 0) return;
+    uint32_t oldOffset = this->descriptorOffset;
+    uint32_t tableSize = 16 * this->numDescriptors;
+    moveDescriptorTable(wadFile, std::max(this->trailingDataEnd, oldOffset + tableSize));
+    this->trailingDataEnd = 0;
+    releaseExtent(oldOffset, tableSize);
+}
+
+void Wad::removeDescriptors(std::fstream &wadFile, uint32_t position, int count) {
+    uint32_t removed = 16 * count;
+    uint32_t tableEnd = this->descriptorOffset + (16 * this->numDescriptors);
+    std::vector<char> tail(tableEnd - position - removed);
+    wadFile.seekg(position + removed);
+    wadFile.read(tail.data(), tail.size());
+    wadFile.seekp(position);
+    wadFile.write(tail.data(), tail.size());
+
+    this->numDescriptors -= count;
+    wadFile.seekp(4);
+    wadFile.write(reinterpret_cast<const char *>(&this->numDescriptors), sizeof(this->numDescriptors));
+    shiftDescriptorOffsets(position + removed, -static_cast<int64_t>(removed));
+}
+
+void Wad::insertDescriptor(std::fstream &wadFile, uint32_t position, FileNode* fileNode) {
+    uint32_t tableEnd = this->descriptorOffset + (16 * this->numDescriptors);
+    std::vector<char> tail(tableEnd - position);
+    wadFile.seekg(position);
+    wadFile.read(tail.data(), tail.size());
+    wadFile.seekp(position + 16);
+    wadFile.write(tail.data(), tail.size());
+
+    this->numDescriptors += 1;
+    wadFile.seekp(4);
+    wadFile.write(reinterpret_cast<const char *>(&this->numDescriptors), sizeof(this->numDescriptors));
+    shiftDescriptorOffsets(position, 16);
+
+    fileNode->descriptorOffset = position;
+    writeDescriptor(wadFile, fileNode);
+}
+
+void Wad::writeDescriptor(std::fstream &wadFile, FileNode* fileNode) {
+    uint32_t length = fileNode->isStandardFile() ? fileNode->fileSize : 0;
+    wadFile.seekp(fileNode->descriptorOffset);
+    wadFile.write(reinterpret_cast<const char *>(&fileNode->fileOffset), sizeof(fileNode->fileOffset));
+    wadFile.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    wadFile.write(padName(NameIndex::lumpName(fileNode)).c_str(), 8);
+}
+
+bool Wad::isExtentShared(FileNode* fileNode) {
+    // WADs may point several descriptors at the same data; such extents must never be freed or written in place
+    if (fileNode->fileSize == 0) return false;
+    uint32_t start = fileNode->fileOffset;
+    uint32_t end = fileNode->fileOffset + fileNode->fileSize;
+    for (const NameIndex::Entry &entry : this->nameIndex.byName) {
+        FileNode* other = entry.node;
+        if (other == fileNode || other->fileSize == 0) continue;
+        if (other->fileOffset < end && start < other->fileOffset + other->fileSize) return true;
     }
+    return false;
+}
+
+void Wad::releaseExtent(uint32_t offset, uint32_t length) {
+    this->freeSpace.release(offset, length);
+}
+
+uint32_t Wad::allocateExtent(std::fstream &wadFile, uint32_t length) {
+    uint32_t offset;
+    if (this->freeSpace.allocate(length, &offset)) return offset;
+
+    // no hole is big enough: grow the data area, starting from any hole that already borders the table
+    uint32_t tail = this->freeSpace.holeEndingAt(this->descriptorOffset);
+    offset = this->descriptorOffset - tail;
+    this->freeSpace.claim(offset, tail);
+    moveDescriptorTable(wadFile, offset + length);
+    return offset;
+}
+
+bool Wad::growInPlace(std::fstream &wadFile, FileNode* fileNode, uint32_t extra) {
+    uint32_t end = fileNode->fileOffset + fileNode->fileSize;
+    if (this->freeSpace.claim(end, extra)) return true;
+
+    // the lump may also grow in place when only free space separates it from the descriptor table
+    uint32_t tail = this->freeSpace.holeEndingAt(this->descriptorOffset);
+    if (end + tail != this->descriptorOffset) return false;
+    this->freeSpace.claim(end, tail);
+    moveDescriptorTable(wadFile, end + extra);
+    return true;
+}
+
+void Wad::zeroFill(std::fstream &wadFile, uint32_t offset, uint32_t length) {
+    std::vector<char> zeros(std::min(length, static_cast<uint32_t>(64 * 1024)), 0);
+    wadFile.seekp(offset);
+    while (length > 0) {
+        uint32_t chunk = std::min(length, static_cast<uint32_t>(zeros.size()));
+        wadFile.write(zeros.data(), chunk);
+        length -= chunk;
+    }
+}
+
+void Wad::resizeLump(std::fstream &wadFile, FileNode* fileNode, uint32_t newSize, bool relocate) {
+    uint32_t oldSize = fileNode->fileSize;
+    uint32_t oldOffset = fileNode->fileOffset;
+    bool shared = isExtentShared(fileNode);
+    if (newSize == oldSize && !relocate) return;
+
+    if (newSize <= oldSize && !relocate) {
+        // shrinking: hand the tail back
+        if (!shared) releaseExtent(oldOffset + newSize, oldSize - newSize);
+        fileNode->fileSize = newSize;
+        if (newSize == 0) fileNode->fileOffset = 0;
+    }
+    else if (oldSize > 0 && !relocate && !shared && growInPlace(wadFile, fileNode, newSize - oldSize)) {
+        zeroFill(wadFile, oldOffset + oldSize, newSize - oldSize);
+        fileNode->fileSize = newSize;
+    }
+    else {
+        // move the lump into a new extent (best fit, or appended to the data area)
+        uint32_t newOffset = allocateExtent(wadFile, newSize);
+        uint32_t kept = std::min(oldSize, newSize);
+        std::vector<char> data(kept);
+        wadFile.seekg(oldOffset);
+        wadFile.read(data.data(), kept);
+        wadFile.seekp(newOffset);
+        wadFile.write(data.data(), kept);
+        zeroFill(wadFile, newOffset + kept, newSize - kept);
+        if (!shared) releaseExtent(oldOffset, oldSize);
+        fileNode->fileOffset = newOffset;
+        fileNode->fileSize = newSize;
+    }
+    fileNode->checksumValid = false;
+    writeDescriptor(wadFile, fileNode);
+}
+
+void Wad::finishUpdate(std::fstream &wadFile) {
+    // pull the descriptor table back over any free space directly in front of it, keeping the WAD compact
+    uint32_t tail = this->freeSpace.holeEndingAt(this->descriptorOffset);
+    if (tail > 0) {
+        uint32_t newOffset = this->descriptorOffset - tail;
+        this->freeSpace.claim(newOffset, tail);
+        moveDescriptorTable(wadFile, newOffset);
+    }
+    wadFile.close();
+
+    // only what lies past both the table and the last lump is cut off
+    uint32_t fileSizeInBytes = this->descriptorOffset + (16 * this->numDescriptors);
+    this->baseDirectory->closingDescriptorOffset = fileSizeInBytes;
+    std::error_code error;
+    std::filesystem::resize_file(this->wadFile, std::max(fileSizeInBytes, this->trailingDataEnd), error);
 }
 
 int Wad::writeToFile(const std::string &path, const char *buffer, int length, int offset) {
-    // split the path into the existing path and the directory to be created
-//    int index = -1;
-//    for (int i = 0; i < path.length(); i++){
-//        if (path.at(i) == '/' && i != path.length()-1){
-//            index = i;
-//        }
-//    }
-
-//    std::cout << path.substr(index, path.length()-index) << std::endl;
     FileNode* thisNode = pathToNode(path, this->baseDirectory);
     if (!thisNode){
 	return -1; // if the path doesn't exist
@@ -435,64 +764,146 @@ int Wad::writeToFile(const std::string &path, const char *buffer, int length, in
     if (!thisNode->isStandardFile()) {
 	return -1; // if the path is not to a file
     }
-    if (thisNode->fileSize != 0) return 0; // non-empty file
+    if (length <= 0 || offset < 0) return 0;
 
-//    std::string newName = path.substr(index + 1, path.length()-index-1); // directory to be created
-//    std::cout << thisNode->filename << " " << newName << std::endl;
-
-    // Step 2: Open the file
     std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
     if (!wadFile.is_open()) {
 	std::cout << "File failed to open" << std::endl;
         return -1;
     }
+    placeTableAfterData(wadFile);
 
-    int newOffset = this->descriptorOffset - offset;
-    int fileSizeInBytes = this->descriptorOffset + (16 * this->numDescriptors);
-    int dataShiftSize = fileSizeInBytes-newOffset; // the data we must shift forward is between our insertPosition and the file's end
-
-    std::vector<char> tempBuffer(dataShiftSize);
-    wadFile.seekg(newOffset);
-    wadFile.read(tempBuffer.data(), dataShiftSize);
+    // make room for the write (data shared with another lump is copied first so the other lump is unaffected)
+    uint32_t end = offset + length;
+    bool shared = isExtentShared(thisNode);
+    if (end > thisNode->fileSize || shared) {
+        resizeLump(wadFile, thisNode, std::max(end, thisNode->fileSize), shared);
+    }
 
-    wadFile.seekg(newOffset);
-    std::streampos beforeWrite = wadFile.tellp();
+    wadFile.seekp(thisNode->fileOffset + offset);
     wadFile.write(buffer, length);
-    std::streampos afterWrite = wadFile.tellp();
+    thisNode->checksumValid = false;
+
+    finishUpdate(wadFile);
+    return length;
+}
+
+int Wad::truncateFile(const std::string &path, int length) {
+    FileNode* thisNode = pathToNode(path, this->baseDirectory);
+    if (!thisNode || !thisNode->isStandardFile() || length < 0) return -1;
+    if (thisNode->fileSize == length) return 0;
+
+    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
+    if (!wadFile.is_open()) {
+        std::cerr << "Failed to open WAD file for updating." << std::endl;
+        return -1;
+    }
+    placeTableAfterData(wadFile);
+    resizeLump(wadFile, thisNode, length, false);
+    finishUpdate(wadFile);
+    return 0;
+}
 
-    wadFile.write(tempBuffer.data(), dataShiftSize);
+int Wad::deleteFile(const std::string &path) {
+    FileNode* thisNode = pathToNode(path, this->baseDirectory);
+    if (!thisNode || !thisNode->isStandardFile()) return -1;
+    if (thisNode->parent->isMapDirectory()) return -1; // map lumps are fixed, just as they can't be created
 
-    int bytesWritten = static_cast<int>(afterWrite-beforeWrite);
+    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
+    if (!wadFile.is_open()) {
+        std::cerr << "Failed to open WAD file for updating." << std::endl;
+        return -1;
+    }
+    placeTableAfterData(wadFile);
 
-    this->descriptorOffset += bytesWritten;
+    if (!isExtentShared(thisNode)) releaseExtent(thisNode->fileOffset, thisNode->fileSize);
+    removeDescriptors(wadFile, thisNode->descriptorOffset, 1);
 
-    thisNode->fileSize = bytesWritten;
-    thisNode->fileOffset = newOffset;
+    std::vector<FileNode*> &siblings = thisNode->parent->children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), thisNode));
+    this->nameIndex.remove(thisNode);
+    delete thisNode;
 
-    std::queue<FileNode*> q;
-    q.push(this->baseDirectory);
-    while (!q.empty()){
-	int size = q.size();
-	for (int j = 0; j < size; j++){
-	    FileNode* current = q.front();
-	    q.pop();
+    finishUpdate(wadFile);
+    return 0;
+}
+
+int Wad::deleteDirectory(const std::string &path) {
+    FileNode* thisNode = pathToNode(path, this->baseDirectory);
+    if (!thisNode || thisNode == this->baseDirectory || thisNode->isStandardFile()) return -1;
+    if (!thisNode->children.empty()) return -1;
+    if (thisNode->isStandardDirectory() && thisNode->closingDescriptorOffset != thisNode->descriptorOffset + 16) return -1;
 
-	    if (current->descriptorOffset >= newOffset) current->descriptorOffset += bytesWritten;
-	    if (current->closingDescriptorOffset >= newOffset) current->closingDescriptorOffset += bytesWritten;
-	    if (current->fileOffset >= newOffset && current != thisNode) current->fileOffset += bytesWritten;
-	    for (int i = 0; i < current->children.size(); i++){
-		q.push(current->children.at(i));
-	    }
-	}
+    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
+    if (!wadFile.is_open()) {
+        std::cerr << "Failed to open WAD file for updating." << std::endl;
+        return -1;
     }
+    placeTableAfterData(wadFile);
 
-    wadFile.seekg(8);
-    wadFile.write(reinterpret_cast<const char *>(&this->descriptorOffset), sizeof(this->descriptorOffset));
-    wadFile.seekg(thisNode->descriptorOffset);
-    wadFile.write(reinterpret_cast<const char *>(&newOffset), sizeof(newOffset));
-    wadFile.seekg(thisNode->descriptorOffset + 4);
-    wadFile.write(reinterpret_cast<const char *>(&bytesWritten), sizeof(bytesWritten));
+    // an empty namespace directory is an adjacent _START/_END pair; a map directory is just its marker
+    removeDescriptors(wadFile, thisNode->descriptorOffset, thisNode->isStandardDirectory() ? 2 : 1);
+
+    std::vector<FileNode*> &siblings = thisNode->parent->children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), thisNode));
+    delete thisNode;
 
-    return bytesWritten;
+    finishUpdate(wadFile);
+    return 0;
 }
 
+int Wad::renamePath(const std::string &from, const std::string &to) {
+    FileNode* thisNode = pathToNode(from, this->baseDirectory);
+    if (!thisNode || thisNode == this->baseDirectory) return -1;
+    if (thisNode->isMapDirectory() || thisNode->parent->isMapDirectory()) return -1; // map structure is fixed
+
+    std::string parentPath, newName;
+    splitPath(to, &parentPath, &newName);
+    FileNode* newParent = pathToNode(parentPath, this->baseDirectory);
+    if (!newParent || !newParent->isStandardDirectory()) return -1;
+    FileNode* target = pathToNode(to, this->baseDirectory);
+    if (thisNode->isStandardFile() && !isValidLumpName(newName, entryBefore(newParent, thisNode, target))) return -1;
+    if (thisNode->isStandardDirectory() && (newName.empty() || newName.size() > 2)) return -1;
+    if (thisNode->isStandardDirectory() && newParent != thisNode->parent) return -1; // directories stay in place
+
+    // an existing target is replaced, as with rename(2)
+    if (target == thisNode) return 0;
+    if (target) {
+        if (target->isStandardFile() != thisNode->isStandardFile()) return -1;
+        int removed = target->isStandardFile() ? deleteFile(to) : deleteDirectory(to);
+        if (removed != 0) return -1;
+    }
+
+    std::fstream wadFile(this->wadFile, std::ios::in | std::ios::out | std::ios::binary);
+    if (!wadFile.is_open()) {
+        std::cerr << "Failed to open WAD file for updating." << std::endl;
+        return -1;
+    }
+    placeTableAfterData(wadFile);
+
+    this->nameIndex.remove(thisNode);
+    thisNode->filename = newName;
+    if (thisNode->isStandardDirectory()) {
+        wadFile.seekp(thisNode->descriptorOffset + 8);
+        wadFile.write(padName(newName + "_START").c_str(), 8);
+        wadFile.seekp(thisNode->closingDescriptorOffset + 8);
+        wadFile.write(padName(newName + "_END").c_str(), 8);
+    }
+    else if (newParent == thisNode->parent) {
+        writeDescriptor(wadFile, thisNode);
+    }
+    else {
+        // move the descriptor to just before the new parent's _END marker
+        removeDescriptors(wadFile, thisNode->descriptorOffset, 1);
+        std::vector<FileNode*> &siblings = thisNode->parent->children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), thisNode));
+        thisNode->descriptorOffset = -1; // no longer in the table, so it must not be shifted
+        insertDescriptor(wadFile, newParent->closingDescriptorOffset, thisNode);
+        thisNode->parent = newParent;
+        newParent->children.push_back(thisNode);
+    }
+    this->nameIndex.insert(thisNode);
+
+    finishUpdate(wadFile);
+    return 0;
+}
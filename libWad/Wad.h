@@ -9,6 +9,8 @@
 #include <fstream>
 #include <iostream>
 #include "FileNode.h"
+#include "NameIndex.h"
+#include "FreeSpace.h"
 
 struct Wad {
     //    The Wad class is used to represent WAD data and should have the following functions. The root of all paths
@@ -25,6 +27,13 @@ struct Wad {
     std::string wadFile;
     std::vector<Wad::Descriptor> descriptors;
     FileNode* baseDirectory;
+    NameIndex nameIndex;
+    FreeSpace freeSpace; // holes in the data area, reused by writes before the WAD file is grown
+    uint32_t trailingDataEnd; // end of any lump data stored after the descriptor table, or 0 if the table comes last
+
+    // Virtual directory exposing name queries: "/.search/<pattern>/" lists every lump matching <pattern>.
+    // Each entry is the lump's path with '/' replaced by ':' (e.g. "E1M1:THINGS"), so equal names stay distinct.
+    static constexpr const char* searchDirectory = "/.search";
 
     static Wad* loadWad(const std::string &path);
     //    Object allocator; dynamically creates a Wad object and loads the WAD file data from path into memory.
@@ -44,6 +53,14 @@ struct Wad {
     // Returns the magic for this WAD data.
 
     FileNode* pathToNode(std::string path, FileNode* fileNode);
+    std::string nodeToPath(FileNode* fileNode);
+    //    Returns the absolute path of fileNode within the WAD tree.
+
+    int findLumps(const std::string &pattern, std::vector<FileNode*> *results);
+    //    Places every lump whose name matches pattern ('*' matches any run of characters, '?' matches one) into
+    //    results, in WAD order. Answered from the name index rather than a tree walk. Returns the number of matches.
+    bool isSearchDirectory(const std::string &path);
+    //    Returns true if path is the search root or a "/.search/<pattern>" query directory.
 
     bool isContent(const std::string &path);
     //    Returns true if path represents content (data), and false otherwise.
@@ -59,19 +76,67 @@ struct Wad {
     //    should be placed in the directory in the same order as they are found in the WAD file. Returns the number of
     //    elements in the directory, or -1 if path does not represent a directory (e.g., if it represents content).
 
+    int getChecksum(const std::string &path, uint32_t *checksum);
+    //    If path represents content, places the CRC32C of its data in checksum and returns 0; otherwise, returns -1.
+    //    The checksum is computed on first use and cached on the node until the content is written to.
+    int computeChecksums(int threads = 0);
+    //    Computes and caches the checksum of every lump that doesn't have one yet, spreading the lumps over
+    //    threads workers (0 picks one per hardware thread). Returns the number of lumps hashed.
+    bool checksumNode(FileNode* fileNode);
+    //    Computes and caches fileNode's checksum if needed. Returns false if the WAD file could not be read.
+
     void createDirectory(const std::string &path);
     //    path includes the name of the new directory to be created. If given a valid path, creates a new directory
     //    using namespace markers at path. The two new namespace markers will be added just before the “_END”
-    //marker of its parent directory. New directories cannot be created inside map markers.
+    //marker of its parent directory. New directories cannot be created inside map markers or over an existing entry.
     void createFile(const std::string &path);
     //path includes the name of the new file to be created. If given a valid path, creates an empty file at path,
     //        with an offset and length of 0. The file will be added to the descriptor list just before the “_END” marker
-    //        of its parent directory. New files cannot be created inside map markers.
+    //        of its parent directory. New files cannot be created inside map markers or over an existing entry.
     int writeToFile(const std::string &path, const char *buffer, int length, int offset = 0);
-    //If given a valid path to an empty file, augments file size and generates a lump offset, then writes length amount
-    //of bytes from the buffer into the file’s lump data. If offset is provided, data should be written starting from that
-    //byte in the lump content. Returns number of bytes copied from buffer, or -1 if path does not represent content
-    //        (e.g., if it represents a directory).
+    //If given a valid path to a file, writes length amount of bytes from the buffer into the file’s lump data, starting
+    //from byte offset of the lump content. A lump that has to grow is extended in place when the space after it is free,
+    //and otherwise moved to the best-fitting hole (or the end of the data area). Returns number of bytes copied from
+    //buffer, or -1 if path does not represent content (e.g., if it represents a directory).
+    int truncateFile(const std::string &path, int length);
+    //    If path represents content, shrinks or zero-extends its data to length bytes, returning freed space to the
+    //    free-extent map. Returns 0 on success, or -1 if path does not represent content.
+    int deleteFile(const std::string &path);
+    //    If path represents content outside a map directory, removes its descriptor and frees its data.
+    //    Returns 0 on success, or -1 otherwise.
+    int deleteDirectory(const std::string &path);
+    //    If path represents an empty directory, removes its marker descriptors. Returns 0 on success, or -1 otherwise.
+    int renamePath(const std::string &from, const std::string &to);
+    //    Renames or moves the file or namespace directory at from to to, replacing an existing file or empty directory
+    //    at to. Files can move between namespace directories; directories can only be renamed in place. Map
+    //    directories and their lumps cannot be renamed. Returns 0 on success, or -1 otherwise.
+
+    static bool isValidLumpName(const std::string &name, const FileNode* previous = nullptr);
+    //    Returns true if name fits in a descriptor and isn't reserved for map or namespace markers. Map lump names
+    //    (THINGS, TEXTMAP, ...) are refused only when previous, the entry the descriptor will follow, is a map.
+    static FileNode* entryBefore(const FileNode* parent, const FileNode* node, const FileNode* skip = nullptr);
+    //    Returns the entry that node's descriptor follows in parent: the sibling before node if node is a child of
+    //    parent, and otherwise parent's last child, since new descriptors are added there. skip (e.g. an entry about
+    //    to be replaced) is passed over. Returns nullptr if nothing precedes it.
+    static void splitPath(const std::string &path, std::string *parent, std::string *name);
+    //    Splits path into the path of its parent directory and its final name, e.g. "/F/F1/LUMP" -> "/F/F1", "LUMP".
+
+    // Descriptor table and data area maintenance used by the operations above. Offsets in the tree are kept in
+    // step with the file, and the file is trimmed to size by finishUpdate. Each update starts with
+    // placeTableAfterData, so that the table is the last thing in the file while it is being changed.
+    void shiftDescriptorOffsets(uint32_t from, int64_t delta);
+    void moveDescriptorTable(std::fstream &wadFile, uint32_t newOffset);
+    void placeTableAfterData(std::fstream &wadFile);
+    void removeDescriptors(std::fstream &wadFile, uint32_t position, int count);
+    void insertDescriptor(std::fstream &wadFile, uint32_t position, FileNode* fileNode);
+    void writeDescriptor(std::fstream &wadFile, FileNode* fileNode);
+    bool isExtentShared(FileNode* fileNode);
+    void releaseExtent(uint32_t offset, uint32_t length);
+    uint32_t allocateExtent(std::fstream &wadFile, uint32_t length);
+    bool growInPlace(std::fstream &wadFile, FileNode* fileNode, uint32_t extra);
+    void zeroFill(std::fstream &wadFile, uint32_t offset, uint32_t length);
+    void resizeLump(std::fstream &wadFile, FileNode* fileNode, uint32_t newSize, bool relocate);
+    void finishUpdate(std::fstream &wadFile);
 };
 
 
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "../libWad/MarkerScanner.h"
+
+// Benchmarks MarkerScanner against the per-name loop loadWad used before it, on a synthetic descriptor table
+// mixing ExMy and MAPxx maps, namespaces and ordinary lumps.
+//
+//     markerbench [--entries=N] [--rounds=R]
+
+static void appendDescriptor(std::vector<char> &table, const std::string &name) {
+    char descriptor[16] = {};
+    memcpy(descriptor + 8, name.data(), std::min<size_t>(name.length(), 8));
+    table.insert(table.end(), descriptor, descriptor + 16);
+}
+
+static std::vector<char> makeTable(size_t entries) {
+    static const char* mapLumps[] = {"THINGS", "LINEDEFS", "SIDEDEFS", "VERTEXES", "SEGS",
+                                     "SSECTORS", "NODES", "SECTORS", "REJECT", "BLOCKMAP"};
+    std::mt19937 rng(1);
+    std::vector<char> table;
+    table.reserve(16 * entries);
+    size_t count = 0;
+    while (count < entries) {
+        int choice = rng() % 100;
+        if (choice < 3) { // Doom map
+            std::string marker = "E" + std::to_string(1 + rng() % 4) + "M" + std::to_string(1 + rng() % 9);
+            if (rng() % 4 == 0) marker += std::string("\0\0\0\1", 4); // junk after the terminating NUL
+            appendDescriptor(table, marker);
+            for (const char* lump : mapLumps) appendDescriptor(table, lump);
+            count += 11;
+        }
+        else if (choice < 6) { // Doom II map
+            char name[9];
+            snprintf(name, sizeof(name), "MAP%02u", static_cast<unsigned>(1 + rng() % 32));
+            appendDescriptor(table, name);
+            for (const char* lump : mapLumps) appendDescriptor(table, lump);
+            count += 11;
+        }
+        else if (choice < 8) { // namespace with a few lumps
+            std::string prefix(1 + rng() % 2, static_cast<char>('A' + rng() % 26));
+            appendDescriptor(table, prefix + "_START");
+            for (int i = 0; i < 4; i++) appendDescriptor(table, "LUMP" + std::to_string(rng() % 1000));
+            std::string end = prefix + "_END";
+            if (rng() % 4 == 0) end += std::string("\0x", 2);
+            appendDescriptor(table, end);
+            count += 6;
+        }
+        else {
+            appendDescriptor(table, "LUMP" + std::to_string(rng() % 10000));
+            count += 1;
+        }
+    }
+    return table;
+}
+
+// the classification loadWad performed before MarkerScanner: a string per name, isdigit/substr checks,
+// and a fixed window of 10 lumps after every ExMy marker
+static std::vector<uint8_t> legacyClassify(const std::vector<char> &table, size_t entries) {
+    std::vector<uint8_t> classes(entries);
+    int index = -999;
+    for (int i = 0; i < entries; i++) {
+        char ascii[9];
+        memcpy(ascii, &table[16 * i + 8], 8);
+        ascii[8] = '\0';
+        std::string givenName = "";
+        for (char j : ascii) {
+            givenName += j;
+        }
+        if (i - 11 == index) index = -999;
+
+        if (givenName.at(0) == 'E' && isdigit(givenName.at(1)) && givenName.at(2) == 'M' && isdigit(givenName.at(3))) {
+            classes[i] = MarkerScanner::MapMarker;
+            index = i;
+        }
+        else if (index != -999) classes[i] = MarkerScanner::inMap;
+        else if (givenName.substr(2, 6) == "_START") classes[i] = MarkerScanner::NamespaceStart;
+        else if (givenName.substr(2, 4) == "_END") classes[i] = MarkerScanner::NamespaceEnd;
+        else classes[i] = MarkerScanner::Lump;
+    }
+    return classes;
+}
+
+template <typename Function>
+static double bestOf(int rounds, Function function) {
+    double best = 1e30;
+    for (int round = 0; round < rounds; round++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = 1000000;
+    int rounds = 5;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--entries=", 10) == 0) entries = std::max(1L, atol(argv[i] + 10));
+        else if (strncmp(argv[i], "--rounds=", 9) == 0) rounds = std::max(1, atoi(argv[i] + 9));
+        else {
+            std::cout << "Usage: markerbench [--entries=N] [--rounds=R]" << std::endl;
+            exit(EXIT_SUCCESS);
+        }
+    }
+
+    std::vector<char> table = makeTable(entries);
+    entries = table.size() / 16;
+
+    std::vector<uint8_t> legacy, scalar(entries), vectorized;
+    double legacyTime = bestOf(rounds, [&]() { legacy = legacyClassify(table, entries); });
+    double scalarTime = bestOf(rounds, [&]() {
+        MarkerScanner::classifyScalar(table.data(), entries, scalar.data());
+        MarkerScanner::resolveMaps(table.data(), scalar.data(), entries);
+    });
+    double vectorizedTime = bestOf(rounds, [&]() { vectorized = MarkerScanner::scan(table.data(), entries); });
+
+    if (scalar != vectorized) {
+        std::cout << "Scalar and vectorized classifications differ." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << entries << " descriptors, best of " << rounds << " rounds" << std::endl;
+    auto report = [&](const char* name, double seconds) {
+        std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << seconds * 1e3 << " ms" << std::setw(10) << seconds * 1e9 / entries
+                  << " ns/entry" << std::setw(10) << legacyTime / seconds << "x" << std::endl;
+    };
+    report("legacy loop", legacyTime);
+    report("scanner (scalar)", scalarTime);
+    report("scanner (vectorized)", vectorizedTime);
+    return 0;
+}
@@ -4,24 +4,67 @@
 #include <cstring>
 #include "../libWad/Wad.h"
 #include "../libWad/FileNode.h"
+#include "Trace.h"
 
 static int my_getattr(const char *path, struct stat *stbuf);
 static int my_mknod(const char *path, mode_t mode, dev_t rdev);
 static int my_mkdir(const char *path, mode_t mode);
+static int my_unlink(const char *path);
+static int my_rmdir(const char *path);
+static int my_rename(const char *from, const char *to);
+static int my_truncate(const char *path, off_t size);
 static int my_read(const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi);
 static int my_write(const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi);
+static int my_getxattr(const char *path, const char *name, char *value, size_t size);
+static int my_listxattr(const char *path, char *list, size_t size);
 static int my_readdir(const char *path, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi);
+static void my_destroy(void *private_data);
 
 static struct fuse_operations operations = {
 	.getattr = my_getattr,
 	.mknod = my_mknod,
 	.mkdir = my_mkdir,
+	.unlink = my_unlink,
+	.rmdir = my_rmdir,
+	.rename = my_rename,
+	.truncate = my_truncate,
 	.read = my_read,
 	.write = my_write,
+	.getxattr = my_getxattr,
+	.listxattr = my_listxattr,
 	.readdir = my_readdir,
+	.destroy = my_destroy,
+};
+
+// set by --trace=<file>; when null, callbacks are not recorded
+static TraceWriter* tracer = nullptr;
+
+// Records one callback into the trace when tracing is enabled. Construct at the top of a callback and
+// pass its return value through finish().
+struct TraceScope {
+    TraceScope(TraceOp op, const std::string &path, off_t offset = 0, size_t size = 0) {
+        if (!tracer) return;
+        record.op = op;
+        record.path = path;
+        record.offset = offset;
+        record.size = size;
+        record.timestamp = tracer->now();
+    }
+
+    int finish(int result) {
+        if (!tracer) return result;
+        uint64_t elapsed = tracer->now() - record.timestamp;
+        record.latency = elapsed > UINT32_MAX ? UINT32_MAX : elapsed;
+        record.result = result;
+        tracer->write(record);
+        return result;
+    }
+
+    TraceRecord record;
 };
 
 int my_getattr(const char *path, struct stat *stbuf){
+    TraceScope trace(TraceOp::Getattr, path);
     // Retrieve the Wad instance from FUSE context
     Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
 
@@ -44,40 +87,160 @@ int my_getattr(const char *path, struct stat *stbuf){
         stbuf->st_uid = mounting_user; // Set owner UID
         stbuf->st_gid = mounting_user; // Set group GID
     }
-    else return -ENOENT;
+    else return trace.finish(-ENOENT);
 
+    return trace.finish(0);
+}
+
+// Returns 0 if node (or, when node is null, a new file or with directory set a new namespace directory) may take
+// path as its name, and otherwise the errno to report. Maps are fixed, and namespace directory names are at most
+// 2 characters.
+static int checkEntryName(Wad* myWad, const std::string &path, const FileNode* node, bool directory){
+    std::string parentPath, name;
+    Wad::splitPath(path, &parentPath, &name);
+    FileNode* parent = myWad->pathToNode(parentPath, myWad->baseDirectory);
+    if (!parent) return -ENOENT;
+    if (parent->isStandardFile()) return -ENOTDIR;
+    if (parent->isMapDirectory()) return -EPERM;
+    if (name.length() > (directory ? 2 : 8)) return -ENAMETOOLONG;
+    if (name.empty()) return -EINVAL;
+    if (!directory) {
+        // an existing entry at path is replaced, so the descriptor follows whatever precedes that entry
+        FileNode* target = myWad->pathToNode(path, myWad->baseDirectory);
+        if (!Wad::isValidLumpName(name, Wad::entryBefore(parent, node, target))) return -EINVAL;
+    }
     return 0;
 }
 
 int my_mknod(const char *path, mode_t mode, dev_t rdev){
+    TraceScope trace(TraceOp::Mknod, path);
     Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+    if (myWad->isContent(path) || myWad->isDirectory(path)) return trace.finish(-EEXIST);
+    int error = checkEntryName(myWad, path, nullptr, false);
+    if (error != 0) return trace.finish(error);
     myWad->createFile(path);
-    return 0;
+    return trace.finish(0);
 }
 
 int my_mkdir(const char* path, mode_t mode){
+    TraceScope trace(TraceOp::Mkdir, path);
     Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+    if (myWad->isContent(path) || myWad->isDirectory(path)) return trace.finish(-EEXIST);
+    int error = checkEntryName(myWad, path, nullptr, true);
+    if (error != 0) return trace.finish(error);
     myWad->createDirectory(path);
-    return 0;
+    return trace.finish(0);
+}
+
+int my_unlink(const char *path){
+    TraceScope trace(TraceOp::Unlink, path);
+    Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+    if (myWad->isDirectory(path)) return trace.finish(-EISDIR);
+    if (!myWad->isContent(path)) return trace.finish(-ENOENT);
+    if (myWad->deleteFile(path) != 0) return trace.finish(-EPERM);
+    return trace.finish(0);
+}
+
+int my_rmdir(const char *path){
+    TraceScope trace(TraceOp::Rmdir, path);
+    Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+    if (myWad->isContent(path)) return trace.finish(-ENOTDIR);
+    if (!myWad->isDirectory(path)) return trace.finish(-ENOENT);
+    std::vector<std::string> contents;
+    if (myWad->getDirectory(path, &contents) > 0) return trace.finish(-ENOTEMPTY);
+    if (myWad->deleteDirectory(path) != 0) return trace.finish(-EPERM);
+    return trace.finish(0);
+}
+
+int my_rename(const char *from, const char *to){
+    // the trace keeps both paths, separated by a '\0'
+    TraceScope trace(TraceOp::Rename, std::string(from) + '\0' + to);
+    Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+    FileNode* node = myWad->pathToNode(from, myWad->baseDirectory);
+    if (!node) return trace.finish(-ENOENT);
+    if (node == myWad->baseDirectory) return trace.finish(-EBUSY);
+    if (node->isMapDirectory() || node->parent->isMapDirectory()) return trace.finish(-EPERM); // map structure is fixed
+
+    int error = checkEntryName(myWad, to, node, !node->isStandardFile());
+    if (error != 0) return trace.finish(error);
+    std::string parentPath, name;
+    Wad::splitPath(to, &parentPath, &name);
+    if (!node->isStandardFile() && myWad->pathToNode(parentPath, myWad->baseDirectory) != node->parent) {
+        // directories can't be moved between parents, so let tools like mv fall back to copy and delete
+        return trace.finish(-EXDEV);
+    }
+
+    // an existing target is replaced, as with rename(2)
+    FileNode* target = myWad->pathToNode(to, myWad->baseDirectory);
+    if (target && target != node) {
+        if (target->isStandardFile() && !node->isStandardFile()) return trace.finish(-ENOTDIR);
+        if (!target->isStandardFile() && node->isStandardFile()) return trace.finish(-EISDIR);
+        if (!target->children.empty()) return trace.finish(-ENOTEMPTY);
+    }
+    if (myWad->renamePath(from, to) != 0) return trace.finish(-EIO);
+    return trace.finish(0);
+}
+
+int my_truncate(const char *path, off_t size){
+    TraceScope trace(TraceOp::Truncate, path, 0, size);
+    Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+    if (myWad->isDirectory(path)) return trace.finish(-EISDIR);
+    if (myWad->truncateFile(path, size) != 0) return trace.finish(-ENOENT);
+    return trace.finish(0);
 }
 
 int my_read(const char* path, char* buf, size_t size, off_t offset, struct fuse_file_info *fi){
+    TraceScope trace(TraceOp::Read, path, offset, size);
     Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
-    return myWad->getContents(path, buf, size, offset);
+    return trace.finish(myWad->getContents(path, buf, size, offset));
 }
 
 static int my_write(const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi){
+    TraceScope trace(TraceOp::Write, path, offset, size);
     Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
-    myWad->writeToFile(path, buf, size, offset);
-    return size;
+    if (myWad->writeToFile(path, buf, size, offset) < 0) return trace.finish(-ENOENT);
+    return trace.finish(size);
+}
+
+// extended attribute carrying a lump's CRC32C, as 8 lowercase hex digits
+static const char checksumAttribute[] = "user.crc32c";
+
+static int my_getxattr(const char *path, const char *name, char *value, size_t size){
+    TraceScope trace(TraceOp::Getxattr, path, 0, size);
+    Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+
+    if (strcmp(name, checksumAttribute) != 0) return trace.finish(-ENODATA);
+    uint32_t checksum;
+    if (myWad->getChecksum(path, &checksum) != 0) {
+        return trace.finish(myWad->isDirectory(path) ? -ENODATA : -ENOENT);
+    }
+
+    char text[9];
+    snprintf(text, sizeof(text), "%08x", checksum);
+    if (size == 0) return trace.finish(8); // caller is asking how big the value is
+    if (size < 8) return trace.finish(-ERANGE);
+    memcpy(value, text, 8);
+    return trace.finish(8);
+}
+
+static int my_listxattr(const char *path, char *list, size_t size){
+    TraceScope trace(TraceOp::Listxattr, path, 0, size);
+    Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
+
+    if (!myWad->isContent(path)) return trace.finish(myWad->isDirectory(path) ? 0 : -ENOENT);
+    if (size == 0) return trace.finish(sizeof(checksumAttribute));
+    if (size < sizeof(checksumAttribute)) return trace.finish(-ERANGE);
+    memcpy(list, checksumAttribute, sizeof(checksumAttribute));
+    return trace.finish(sizeof(checksumAttribute));
 }
 
 static int my_readdir(const char *path, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi){
+    TraceScope trace(TraceOp::Readdir, path, offset);
     Wad* myWad = static_cast<Wad*>(fuse_get_context()->private_data);
 
     if (strcmp(path, "/") != 0) {
         if (!myWad->isDirectory(path)) {
-            return -ENOENT;
+            return trace.finish(-ENOENT);
         }
     }
 
@@ -90,10 +253,42 @@ static int my_readdir(const char *path, void *buf, fuse_fill_dir_t filler, off_t
         filler(buf, entry.c_str(), NULL, 0);
     }
 
-    return 0;
+    return trace.finish(0);
+}
+
+static void my_destroy(void *private_data){
+    if (tracer) {
+        tracer->close();
+    }
 }
 
 int main (int argc, char* argv[]){
+	// pull out our own options before the positional arguments are interpreted
+	std::string tracePath = "";
+	int checksumThreads = -1;
+	for (int i = 1; i < argc; i++){
+		bool ours = false;
+		if (strncmp(argv[i], "--trace=", 8) == 0){
+			tracePath = argv[i] + 8;
+			ours = true;
+		}
+		else if (strcmp(argv[i], "--checksums") == 0){
+			checksumThreads = 0;
+			ours = true;
+		}
+		else if (strncmp(argv[i], "--checksums=", 12) == 0){
+			checksumThreads = atoi(argv[i] + 12);
+			ours = true;
+		}
+		if (ours){
+			for (int j = i; j < argc - 1; j++){
+				argv[j] = argv[j+1];
+			}
+			argc--;
+			i--;
+		}
+	}
+
 	if (argc < 3){
 		std::cout << "Not enough arguments." << std::endl;
 		exit(EXIT_SUCCESS);
@@ -108,6 +303,23 @@ int main (int argc, char* argv[]){
 	}
 	Wad* myWad = Wad::loadWad(wadPath);
 
+	if (myWad && checksumThreads >= 0){
+		// hash every lump up front so checksum queries never have to read lump data
+		myWad->computeChecksums(checksumThreads);
+	}
+
+	if (!tracePath.empty()){
+		// fuse_main daemonizes and changes directory, so resolve relative trace paths now
+		if (tracePath.at(0) != '/'){
+			tracePath = std::string(get_current_dir_name()) + "/" + tracePath;
+		}
+		tracer = new TraceWriter();
+		if (!tracer->open(tracePath)){
+			std::cout << "Trace file failed to open." << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	argv[argc - 2] = argv[argc-1];
 	argc--;
 
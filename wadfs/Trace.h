@@ -0,0 +1,148 @@
+#ifndef LABORATORY_TRACE_H
+#define LABORATORY_TRACE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+// Binary trace of wadfs callbacks, written by "wadfs --trace=<file>" and consumed by wadreplay.
+// Layout: an 8-byte header ("WTRC" followed by a uint32 version), then one record per callback.
+// Each record is a fixed 32-byte head followed by pathLength bytes of path (not null-terminated).
+// All fields are stored in host byte order. Rename records store both paths, separated by a '\0'.
+// Records are written as callbacks finish, so on a multi-threaded mount the file is in completion order;
+// sort by timestamp (taken when the callback starts) to recover the order requests arrived in.
+
+enum struct TraceOp : uint8_t {
+    Getattr,
+    Mknod,
+    Mkdir,
+    Read,
+    Write,
+    Readdir,
+    Getxattr,
+    Listxattr,
+    Unlink,
+    Rmdir,
+    Rename,
+    Truncate
+};
+
+inline const char* traceOpName(TraceOp op) {
+    switch (op) {
+        case TraceOp::Getattr: return "getattr";
+        case TraceOp::Mknod: return "mknod";
+        case TraceOp::Mkdir: return "mkdir";
+        case TraceOp::Read: return "read";
+        case TraceOp::Write: return "write";
+        case TraceOp::Readdir: return "readdir";
+        case TraceOp::Getxattr: return "getxattr";
+        case TraceOp::Listxattr: return "listxattr";
+        case TraceOp::Unlink: return "unlink";
+        case TraceOp::Rmdir: return "rmdir";
+        case TraceOp::Rename: return "rename";
+        case TraceOp::Truncate: return "truncate";
+    }
+    return "unknown";
+}
+
+static const int traceOpCount = 12;
+
+struct TraceRecord {
+    TraceOp op;
+    uint64_t timestamp; // nanoseconds since the trace was opened
+    uint32_t latency;   // nanoseconds spent in the callback, saturated at UINT32_MAX
+    int32_t result;     // value returned to FUSE
+    int64_t offset;
+    uint32_t size;
+    std::string path;
+};
+
+static const char traceMagic[4] = {'W', 'T', 'R', 'C'};
+static const uint32_t traceVersion = 1;
+
+struct TraceWriter {
+    TraceWriter() : file(nullptr) {}
+    ~TraceWriter() { close(); }
+
+    bool open(const std::string &path) {
+        file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        fwrite(traceMagic, 1, sizeof(traceMagic), file);
+        fwrite(&traceVersion, sizeof(traceVersion), 1, file);
+        start = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void write(const TraceRecord &record) {
+        // fixed-size head: op, 1 byte padding, pathLength, result, timestamp, latency, size, offset
+        char head[32] = {};
+        uint16_t pathLength = record.path.length() > UINT16_MAX ? UINT16_MAX : record.path.length();
+        head[0] = static_cast<char>(record.op);
+        memcpy(head + 2, &pathLength, sizeof(pathLength));
+        memcpy(head + 4, &record.result, sizeof(record.result));
+        memcpy(head + 8, &record.timestamp, sizeof(record.timestamp));
+        memcpy(head + 16, &record.latency, sizeof(record.latency));
+        memcpy(head + 20, &record.size, sizeof(record.size));
+        memcpy(head + 24, &record.offset, sizeof(record.offset));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file) return;
+        fwrite(head, 1, sizeof(head), file);
+        fwrite(record.path.data(), 1, pathLength, file);
+    }
+
+    FILE* file;
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point start;
+};
+
+inline bool readTrace(const std::string &path, std::vector<TraceRecord> *records) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t version;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, traceMagic, sizeof(magic)) != 0
+        || fread(&version, sizeof(version), 1, file) != 1 || version != traceVersion) {
+        fclose(file);
+        return false;
+    }
+
+    char head[32];
+    while (fread(head, 1, sizeof(head), file) == sizeof(head)) {
+        TraceRecord record;
+        uint16_t pathLength;
+        record.op = static_cast<TraceOp>(head[0]);
+        memcpy(&pathLength, head + 2, sizeof(pathLength));
+        memcpy(&record.result, head + 4, sizeof(record.result));
+        memcpy(&record.timestamp, head + 8, sizeof(record.timestamp));
+        memcpy(&record.latency, head + 16, sizeof(record.latency));
+        memcpy(&record.size, head + 20, sizeof(record.size));
+        memcpy(&record.offset, head + 24, sizeof(record.offset));
+        record.path.resize(pathLength);
+        if (fread(&record.path[0], 1, pathLength, file) != pathLength) break; // truncated tail
+        if (static_cast<uint8_t>(record.op) >= traceOpCount) continue; // op from a newer wadfs
+        records->push_back(record);
+    }
+    fclose(file);
+    return true;
+}
+
+
+#endif //LABORATORY_TRACE_H
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <shared_mutex>
+#include <cstring>
+#include "../libWad/Wad.h"
+#include "../wadfs/Trace.h"
+
+// Replays a trace recorded by "wadfs --trace=<file>" directly against libWad, without FUSE in the loop.
+// Each record is turned back into the Wad calls its callback makes and timed on its own. Writes are
+// replayed with zero-filled buffers of the recorded size, so point this at a copy of the WAD.
+
+// getxattr counts as mutating: computing a checksum caches it on the FileNode
+static bool isMutating(TraceOp op) {
+    return op == TraceOp::Mknod || op == TraceOp::Mkdir || op == TraceOp::Write || op == TraceOp::Unlink
+           || op == TraceOp::Rmdir || op == TraceOp::Rename || op == TraceOp::Truncate || op == TraceOp::Getxattr;
+}
+
+// mirrors the corresponding callback in wadfs/FuseExample.cpp
+static void replayRecord(Wad* wad, const TraceRecord &record, std::vector<char> &buffer) {
+    switch (record.op) {
+        case TraceOp::Getattr:
+            if (!wad->isDirectory(record.path) && wad->isContent(record.path)) {
+                wad->getSize(record.path);
+            }
+            break;
+        case TraceOp::Mknod:
+            wad->createFile(record.path);
+            break;
+        case TraceOp::Mkdir:
+            wad->createDirectory(record.path);
+            break;
+        case TraceOp::Read:
+            if (buffer.size() < record.size) buffer.resize(record.size);
+            wad->getContents(record.path, buffer.data(), record.size, record.offset);
+            break;
+        case TraceOp::Write:
+            if (buffer.size() < record.size) buffer.resize(record.size);
+            std::fill(buffer.begin(), buffer.begin() + record.size, 0);
+            wad->writeToFile(record.path, buffer.data(), record.size, record.offset);
+            break;
+        case TraceOp::Readdir: {
+            std::vector<std::string> contents;
+            if (record.path == "/" || wad->isDirectory(record.path)) {
+                wad->getDirectory(record.path, &contents);
+            }
+            break;
+        }
+        case TraceOp::Getxattr: {
+            uint32_t checksum;
+            wad->getChecksum(record.path, &checksum);
+            break;
+        }
+        case TraceOp::Listxattr:
+            if (!wad->isContent(record.path)) wad->isDirectory(record.path);
+            break;
+        case TraceOp::Unlink:
+            wad->deleteFile(record.path);
+            break;
+        case TraceOp::Rmdir:
+            wad->deleteDirectory(record.path);
+            break;
+        case TraceOp::Rename: {
+            size_t split = record.path.find('\0');
+            if (split != std::string::npos) {
+                wad->renamePath(record.path.substr(0, split), record.path.substr(split + 1));
+            }
+            break;
+        }
+        case TraceOp::Truncate:
+            wad->truncateFile(record.path, record.size);
+            break;
+    }
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted.at(index);
+}
+
+int main(int argc, char* argv[]) {
+    int threads = 1;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::max(1, atoi(argv[i] + 10));
+        }
+        else {
+            positional.push_back(argv[i]);
+        }
+    }
+    if (positional.size() != 2) {
+        std::cout << "Usage: wadreplay [--threads=N] tracefile somewadfile.wad" << std::endl;
+        exit(EXIT_SUCCESS);
+    }
+
+    std::vector<TraceRecord> records;
+    if (!readTrace(positional.at(0), &records)) {
+        std::cout << "Trace file failed to open." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    // replay in the order the callbacks started, not the order they were written in
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord &a, const TraceRecord &b) {
+        return a.timestamp < b.timestamp;
+    });
+    Wad* wad = Wad::loadWad(positional.at(1));
+    if (!wad) exit(EXIT_FAILURE);
+
+    // Workers pull records in trace order. Lookups and reads share the lock, while calls that modify
+    // the WAD take it exclusively, since libWad itself does no locking.
+    std::shared_mutex lock;
+    std::atomic<size_t> next(0);
+    std::vector<std::vector<std::vector<uint64_t>>> latencies(threads, std::vector<std::vector<uint64_t>>(traceOpCount));
+
+    auto worker = [&](int id) {
+        std::vector<char> buffer;
+        for (size_t i = next++; i < records.size(); i = next++) {
+            const TraceRecord &record = records.at(i);
+            auto start = std::chrono::steady_clock::now();
+            if (isMutating(record.op)) {
+                std::unique_lock<std::shared_mutex> exclusive(lock);
+                replayRecord(wad, record, buffer);
+            }
+            else {
+                std::shared_lock<std::shared_mutex> shared(lock);
+                replayRecord(wad, record, buffer);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            latencies.at(id).at(static_cast<int>(record.op)).push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(worker, i);
+    }
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // recorded latencies, for comparison against the replayed ones
+    std::vector<std::vector<uint64_t>> recorded(traceOpCount);
+    for (const TraceRecord &record : records) {
+        recorded.at(static_cast<int>(record.op)).push_back(record.latency);
+    }
+
+    std::cout << records.size() << " ops replayed on " << threads << " thread(s) in " << std::fixed
+              << std::setprecision(3) << seconds << " s (" << std::setprecision(0)
+              << (seconds > 0 ? records.size() / seconds : 0) << " ops/s)" << std::endl;
+    std::cout << std::left << std::setw(10) << "op" << std::right << std::setw(10) << "count"
+              << std::setw(14) << "mean ns" << std::setw(14) << "p50 ns" << std::setw(14) << "p99 ns"
+              << std::setw(14) << "max ns" << std::setw(18) << "recorded mean" << std::endl;
+    for (int op = 0; op < traceOpCount; op++) {
+        std::vector<uint64_t> merged;
+        for (int i = 0; i < threads; i++) {
+            merged.insert(merged.end(), latencies.at(i).at(op).begin(), latencies.at(i).at(op).end());
+        }
+        if (merged.empty()) continue;
+        std::sort(merged.begin(), merged.end());
+
+        uint64_t total = 0;
+        for (uint64_t latency : merged) total += latency;
+        uint64_t recordedTotal = 0;
+        for (uint64_t latency : recorded.at(op)) recordedTotal += latency;
+
+        std::cout << std::left << std::setw(10) << traceOpName(static_cast<TraceOp>(op)) << std::right
+                  << std::setw(10) << merged.size() << std::setw(14) << total / merged.size()
+                  << std::setw(14) << percentile(merged, 0.5) << std::setw(14) << percentile(merged, 0.99)
+                  << std::setw(14) << merged.back() << std::setw(18) << recordedTotal / recorded.at(op).size()
+                  << std::endl;
+    }
+
+    delete wad;
+    return 0;
+}